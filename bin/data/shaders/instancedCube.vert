@@ -0,0 +1,17 @@
+#version 150
+
+// one unit cube, moved and scaled per instance, see cubeRenderer.cpp
+
+uniform mat4 modelViewProjectionMatrix;
+uniform vec3 modelScale;    // the GUI scale sliders, moves the centers apart, the cubes stay cubes
+
+in vec4 position;
+in vec4 instancePosSize;    // xyz = center, w = edge size
+in vec4 instanceColor;
+
+out vec4 colorVarying;
+
+void main() {
+    colorVarying = instanceColor;
+    gl_Position = modelViewProjectionMatrix * vec4(position.xyz * instancePosSize.w + instancePosSize.xyz * modelScale, 1.0);
+}
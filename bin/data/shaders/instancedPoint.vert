@@ -0,0 +1,18 @@
+#version 150
+
+// distant cubes, or whole distant clusters, as one square point each, see cubeRenderer.cpp
+
+uniform mat4 modelViewProjectionMatrix;
+uniform vec3 modelScale;    // the GUI scale sliders, as in instancedCube.vert
+uniform float pixelsPerUnit;    // pixels across for one unit at a distance of one unit
+
+in vec4 position;   // xyz = center, w = size
+in vec4 color;
+
+out vec4 colorVarying;
+
+void main() {
+    colorVarying = color;
+    gl_Position = modelViewProjectionMatrix * vec4(position.xyz * modelScale, 1.0);
+    gl_PointSize = max(position.w * pixelsPerUnit / gl_Position.w, 1.0);
+}
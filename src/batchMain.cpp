@@ -0,0 +1,153 @@
+/*********************************************************
+ batchMain.cpp
+ headless batch mode for Data Crystals
+ 
+ Usage:
+    DataCrystals --batch [options] [file.csv ...]
+ 
+    file.csv        one or more files from bin/data/input, default is every file there
+    --all           load every CSV at once, one crystal
+    --category N    only this category, default is one crystal per category
+    --out DIR       output folder under bin/data, default outputs
+    --seed N        random seed, for repeatable crystals
+    --max-cycles N  give up on a crystal after N cycles, default 1000000
+    --merged        save one voxelised, watertight surface instead of every cube
+    --voxels N      voxels per cube edge for --merged, default 2
+    --format F      stl, ply or obj, default stl
+ 
+ Each file is parsed once, its categories are then switched in memory.
+ Each crystal is clustered until there is a single cluster, as fast as the
+ CPU allows, then saved to DIR/<file>_<category>.<format>
+ 
+ **********************************************************/
+
+#include "ofMain.h"
+#include "dataCrystalsApp.h"
+#include "batchMain.h"
+#include "meshWriter.h"
+
+#define DEFAULT_BATCH_MAX_CYCLES (1000000)
+
+
+static void printBatchUsage() {
+    cout << "usage: DataCrystals --batch [--all] [--category N] [--out DIR] [--seed N] [--max-cycles N] [--merged] [--voxels N] [--format stl|ply|obj] [file.csv ...]\n";
+}
+
+int runBatch( int argc, char *argv[] ) {
+    bool bAll = false;
+    int category = 0;           // 0 = every category
+    string outDir = "outputs";
+    unsigned long maxCycles = DEFAULT_BATCH_MAX_CYCLES;
+    bool bMerged = false;
+    bool bSeed = false;
+    int seed = 0;
+    int voxelResolution = VOXEL_DEFAULT_RESOLUTION;
+    string format = "stl";
+    vector<string> filenames;
+    
+    //-- argv[1] is --batch
+    for( int i = 2; i < argc; i++ ) {
+        string arg = argv[i];
+        bool bHasValue = (i + 1 < argc);
+        
+        if( arg == "--all" )
+            bAll = true;
+        else if( arg == "--category" && bHasValue )
+            category = ofToInt(argv[++i]);
+        else if( arg == "--out" && bHasValue )
+            outDir = argv[++i];
+        else if( arg == "--seed" && bHasValue ) {
+            bSeed = true;
+            seed = ofToInt(argv[++i]);
+        }
+        else if( arg == "--max-cycles" && bHasValue )
+            maxCycles = strtoul(argv[++i], NULL, 10);
+        else if( arg == "--merged" )
+            bMerged = true;
+        else if( arg == "--voxels" && bHasValue )
+            voxelResolution = ofToInt(argv[++i]);
+        else if( arg == "--format" && bHasValue && isMeshFileFormat(argv[i+1]) )
+            format = ofToLower(argv[++i]);
+        else if( arg.size() > 2 && arg.substr(0, 2) == "--" ) {
+            printBatchUsage();
+            return 1;
+        }
+        else
+            filenames.push_back(arg);
+    }
+    
+    //-- file system + data path, normally done by ofSetupOpenGL()
+    ofInit();
+    
+    //-- after ofInit(), which seeds the random numbers itself
+    if( bSeed )
+        ofSeedRandom(seed);
+    
+    dataCrystalsApp app;
+    app.setupBatch();
+    
+    if( app.getCSVFiles().size() == 0 ) {
+        cout << "ERROR runBatch() no CSV files in " << ofToDataPath("input") << "\n";
+        return 1;
+    }
+    
+    ofDirectory::createDirectory(ofToDataPath(outDir), false, true);
+    
+    //-- one job per file (or one for --all), per category
+    if( bAll ) {
+        filenames.clear();
+        filenames.push_back("");
+    }
+    else if( filenames.size() == 0 ) {
+        for( size_t i = 0; i < app.getCSVFiles().size(); i++ )
+            filenames.push_back(app.getCSVFiles()[i].getFileName());
+    }
+    
+    int minCategory = (category == 0 || bAll) ? app.minDataCategory : category;
+    int maxCategory = (category == 0 || bAll) ? app.maxDataCategory : category;
+    
+    //-- --all shows every category at once
+    if( bAll )
+        maxCategory = minCategory;
+    
+    int numFailed = 0;
+    
+    for( size_t f = 0; f < filenames.size(); f++ ) {
+        string baseName = filenames[f].empty() ? "all" : ofFilePath::getBaseName(filenames[f]);
+        
+        for( int c = minCategory; c <= maxCategory; c++ ) {
+            uint64_t startTime = ofGetElapsedTimeMillis();
+            
+            app.loadBatchData(filenames[f], c);
+            
+            if( app.numVisible == 0 )
+                continue;   // nothing in this category
+            
+            unsigned long numCycles = app.clusterToConvergence(maxCycles);
+            
+            char outName[256];
+            if( bAll )
+                sprintf(outName, "%s.%s", baseName.c_str(), format.c_str());
+            else
+                sprintf(outName, "%s_%d.%s", baseName.c_str(), c, format.c_str());
+            
+            string outPath = outDir + "/" + outName;
+            if( bMerged )
+                app.saveMergedMesh(outPath, voxelResolution);
+            else
+                app.saveMesh(outPath);
+            
+            cout << outPath << ": " << app.numVisible << " points, " << numCycles << " cycles, "
+                 << (ofGetElapsedTimeMillis() - startTime) << " ms";
+            
+            if( app.isClusterDone() == false ) {
+                cout << " (NOT converged)";
+                numFailed++;
+            }
+            
+            cout << "\n";
+        }
+    }
+    
+    return (numFailed == 0) ? 0 : 2;
+}
@@ -0,0 +1,10 @@
+/*********************************************************
+ batchMain.h
+ headless batch mode for Data Crystals, no window or GL context
+ 
+ **********************************************************/
+
+#pragma once
+
+//-- called from main() when the first argument is --batch, returns the exit code
+int runBatch( int argc, char *argv[] );
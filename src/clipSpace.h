@@ -0,0 +1,48 @@
+/*********************************************************
+    clipSpace.h
+    World to clip space helpers for Data Crystals
+    
+    Notes:
+    - OF matrices multiply row vectors, clip = (x, y, z, 1) * mvp,
+        element (row, col) is read through mvp(row, col)
+    
+    - shared by cubeRenderer (frustum culling, level of detail) and
+        labelRenderer (label placement), so both agree on what is in view
+**********************************************************/
+
+
+#ifndef __clipSpace__
+#define __clipSpace__
+
+#include "ofMain.h"
+#include <string.h>
+
+#define NUM_FRUSTUM_PLANES (6)
+
+
+//-- clip coordinates of a world position, w > 0 is in front of the camera
+inline ofVec4f worldToClip( const ofMatrix4x4 &mvp, float x, float y, float z ) {
+    return ofVec4f(mvp(0, 0) * x + mvp(1, 0) * y + mvp(2, 0) * z + mvp(3, 0),
+                   mvp(0, 1) * x + mvp(1, 1) * y + mvp(2, 1) * z + mvp(3, 1),
+                   mvp(0, 2) * x + mvp(1, 2) * y + mvp(2, 2) * z + mvp(3, 2),
+                   mvp(0, 3) * x + mvp(1, 3) * y + mvp(2, 3) * z + mvp(3, 3));
+}
+
+//-- left, right, bottom, top, near, far, each a*x + b*y + c*z + d >= 0 inside (Gribb & Hartmann),
+//-- the planes are sums of the columns of mvp
+inline void getFrustumPlanes( const ofMatrix4x4 &mvp, float planes[NUM_FRUSTUM_PLANES][4] ) {
+    for( int p = 0; p < NUM_FRUSTUM_PLANES; p++ ) {
+        int axis = p / 2;
+        float sign = (p & 1) ? -1.0f : 1.0f;
+        
+        for( int row = 0; row < 4; row++ )
+            planes[p][row] = mvp(row, 3) + sign * mvp(row, axis);
+    }
+}
+
+//-- exact compare, for "has the camera moved since we last built"
+inline bool isSameMatrix( const ofMatrix4x4 &a, const ofMatrix4x4 &b ) {
+    return memcmp(a.getPtr(), b.getPtr(), 16 * sizeof(float)) == 0;
+}
+
+#endif /* defined(__clipSpace__) */
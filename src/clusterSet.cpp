@@ -0,0 +1,135 @@
+/*********************************************************
+ clusterSet.cpp
+ Disjoint-set cluster membership implementation for Data Crystals
+ 
+ **********************************************************/
+
+#include "clusterSet.h"
+
+
+clusterSet::clusterSet() {
+    nextLabel = 1;
+    freeRecord = CLUSTER_SET_END;
+}
+
+void clusterSet::reset( unsigned long n ) {
+    parent.resize(n);
+    nextMember.assign(n, CLUSTER_SET_END);
+    
+    for( unsigned long i = 0; i < n; i++ )
+        parent[i] = (uint32_t)i;
+    
+    records.clear();
+    freeRecord = CLUSTER_SET_END;
+    
+    nextLabel = 1;
+}
+
+clusterSet::setRecord *clusterSet::getRecord( unsigned long root ) {
+    if( parent[root] == root )
+        return NULL;
+    
+    return &records[parent[root] & ~CLUSTER_SET_ROOT_BIT];
+}
+
+//-- a free one if there is one, invalidates setRecord pointers
+uint32_t clusterSet::newRecord() {
+    if( freeRecord == CLUSTER_SET_END ) {
+        records.push_back(setRecord());
+        return (uint32_t)(records.size() - 1);
+    }
+    
+    uint32_t r = freeRecord;
+    freeRecord = records[r].top;
+    return r;
+}
+
+//-- iterative, with path halving: every node on the way up skips to its grandparent
+unsigned long clusterSet::find( unsigned long i ) {
+    while( isRoot(i) == false ) {
+        unsigned long p = parent[i];
+        if( isRoot(p) == false )
+            parent[i] = parent[p];
+        
+        i = parent[i];
+    }
+    
+    return i;
+}
+
+unsigned long clusterSet::getSize( unsigned long i ) {
+    setRecord *record = getRecord(find(i));
+    return record ? record->size : 1;
+}
+
+unsigned long clusterSet::getLabel( unsigned long i ) {
+    setRecord *record = getRecord(find(i));
+    return record ? record->label : 0;
+}
+
+unsigned long clusterSet::getTop( unsigned long i ) {
+    unsigned long root = find(i);
+    setRecord *record = getRecord(root);
+    return record ? record->top : root;
+}
+
+unsigned long clusterSet::unite( unsigned long sub, unsigned long main ) {
+    unsigned long subRoot = find(sub);
+    unsigned long mainRoot = find(main);
+    
+    if( subRoot == mainRoot )
+        return mainRoot;
+    
+    setRecord *subRecord = getRecord(subRoot);
+    setRecord *mainRecord = getRecord(mainRoot);
+    
+    //-- unattached, give it a new cluster label
+    uint32_t mainLabel = mainRecord ? mainRecord->label : (uint32_t)nextLabel++;
+    uint32_t mainTop = mainRecord ? mainRecord->top : (uint32_t)mainRoot;
+    
+    uint32_t subSize = subRecord ? subRecord->size : 1;
+    uint32_t mainSize = mainRecord ? mainRecord->size : 1;
+    uint32_t subLast = subRecord ? subRecord->lastMember : (uint32_t)subRoot;
+    uint32_t mainLast = mainRecord ? mainRecord->lastMember : (uint32_t)mainRoot;
+    
+    //-- union by size: hang the smaller tree off the bigger one, which keeps its record, a set of
+    //-- more than one is always bigger than an unattached datum
+    unsigned long newRoot = mainRoot;
+    unsigned long oldRoot = subRoot;
+    uint32_t newLast = mainLast;
+    uint32_t oldLast = subLast;
+    if( subSize > mainSize ) {
+        newRoot = subRoot;
+        oldRoot = mainRoot;
+        newLast = subLast;
+        oldLast = mainLast;
+    }
+    
+    uint32_t recordBits;
+    if( parent[newRoot] == newRoot )
+        recordBits = CLUSTER_SET_ROOT_BIT | newRecord();
+    else {
+        recordBits = parent[newRoot];
+        
+        //-- the smaller one's record is free now
+        if( parent[oldRoot] != oldRoot ) {
+            uint32_t oldRecord = parent[oldRoot] & ~CLUSTER_SET_ROOT_BIT;
+            records[oldRecord].top = freeRecord;
+            freeRecord = oldRecord;
+        }
+    }
+    
+    parent[oldRoot] = (uint32_t)newRoot;
+    parent[newRoot] = recordBits;
+    
+    //-- the root is always first in its own list, append the old list after it
+    nextMember[newLast] = (uint32_t)oldRoot;
+    
+    setRecord &record = records[recordBits & ~CLUSTER_SET_ROOT_BIT];
+    record.size = subSize + mainSize;
+    record.label = mainLabel;
+    record.top = mainTop;
+    record.lastMember = oldLast;
+    
+    return newRoot;
+}
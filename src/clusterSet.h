@@ -0,0 +1,104 @@
+/*********************************************************
+    clusterSet.h
+    Disjoint-set (union-find) cluster membership for Data Crystals
+ 
+    Notes:
+    - indexed by data index, this is the source of truth for which
+        cluster a datum belongs to
+ 
+    - path compression + union by size, so find() and unite()
+        are near O(1) and never recurse, no matter how long the
+        parent/child chains in the crystal get
+ 
+    - each set also remembers its display label (the old cluster ID)
+        and the top-level datum of its parent/child tree
+ 
+    - members of a set are kept in a linked list that starts at the
+        root, so a set can be walked in O(set size)
+ 
+    - 32-bit indices, so at most 2^31 - 1 data; per datum there is only
+        the parent and the next member, 8 bytes; an unattached datum needs
+        nothing else, the root of a bigger set points at a record with its
+        size, label, top and last member, 16 bytes per set
+ 
+    - records of sets that were merged away are re-used, so there are only
+        ever as many as the most sets of more than one alive at once; the
+        record (set) index is handed out so callers can keep their own
+        per-set data, see getSetIndex()
+**********************************************************/
+
+
+#ifndef __clusterSet__
+#define __clusterSet__
+
+#include "ofMain.h"
+#include <stdint.h>
+
+#define CLUSTER_SET_END ((uint32_t)0xFFFFFFFF)      // end of a member list
+#define CLUSTER_SET_ROOT_BIT ((uint32_t)0x80000000) // parent of a set root: this bit + its record index
+
+
+class clusterSet  {
+
+public:
+    clusterSet();
+    
+    //-- n unattached data, every one in its own set
+    void reset( unsigned long n );
+    unsigned long getNumElements() { return parent.size(); }
+    
+    //-- root of the set that i belongs to
+    unsigned long find( unsigned long i );
+    bool same( unsigned long a, unsigned long b ) { return find(a) == find(b); }
+    
+    //-- merges the set of sub into the set of main, main keeps its label and top, returns the new root
+    unsigned long unite( unsigned long sub, unsigned long main );
+    
+    //-- number of data in the set of i, 1 = unattached
+    unsigned long getSize( unsigned long i );
+    
+    //-- display label of the set, 0 = unattached
+    unsigned long getLabel( unsigned long i );
+    
+    //-- datum id of the top-level datum in the set of i
+    unsigned long getTop( unsigned long i );
+    
+    //-- for( m = root; m != CLUSTER_SET_END; m = getNextMember(m) ) walks every member of a set
+    unsigned long getNextMember( unsigned long m ) { return nextMember[m]; }
+    
+    //-- index of the set root is the root of, below getNumSets(), CLUSTER_SET_END when it is unattached
+    //-- doesn't call find(), so it is safe from worker threads; a set keeps its index until it is
+    //-- merged into a bigger one, after that the index can come back for a new set
+    unsigned long getSetIndex( unsigned long root ) {
+        return (parent[root] == root) ? CLUSTER_SET_END : (parent[root] & ~CLUSTER_SET_ROOT_BIT);
+    }
+    unsigned long getNumSets() { return records.size(); }
+    
+private:
+    //-- what only the root of a set of more than one needs
+    struct setRecord {
+        uint32_t size;
+        uint32_t label;
+        uint32_t top;
+        uint32_t lastMember;
+    };
+    
+    //-- i for an unattached datum, CLUSTER_SET_ROOT_BIT | record for the root of a bigger set
+    vector<uint32_t> parent;
+    vector<uint32_t> nextMember;
+    
+    //-- a set only gets one when two unattached data join, so there are never more than n / 2
+    //-- free ones are chained through top, from freeRecord
+    vector<setRecord> records;
+    uint32_t freeRecord;
+    
+    unsigned long nextLabel;
+    
+    bool isRoot( unsigned long i ) { return parent[i] == i || (parent[i] & CLUSTER_SET_ROOT_BIT) != 0; }
+    
+    //-- record of a root, NULL when it is unattached
+    setRecord *getRecord( unsigned long root );
+    uint32_t newRecord();
+};
+
+#endif /* defined(__clusterSet__) */
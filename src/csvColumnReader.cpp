@@ -0,0 +1,185 @@
+/*********************************************************
+ csvColumnReader.cpp
+ Fast projected CSV loading implementation for Data Crystals
+ 
+ **********************************************************/
+
+#include "csvColumnReader.h"
+#include "mappedFile.h"
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+#define CSV_EST_BYTES_PER_ROW (32)      // for reserving the output arrays up front
+#define CSV_MAX_MANTISSA_DIGITS (19)    // what fits in 64 bits
+
+
+static const double powersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isDigit( char c ) {
+    return c >= '0' && c <= '9';
+}
+
+float parseCSVFloat( const char *p, const char *end ) {
+    //-- leading spaces and an opening quote
+    while( p < end && (*p == ' ' || *p == '\t' || *p == '"') )
+        p++;
+    
+    bool bNegative = false;
+    if( p < end && (*p == '-' || *p == '+') ) {
+        bNegative = (*p == '-');
+        p++;
+    }
+    
+    uint64_t mantissa = 0;
+    int numDigits = 0;
+    int exponent = 0;
+    
+    for( ; p < end && isDigit(*p); p++ ) {
+        if( numDigits < CSV_MAX_MANTISSA_DIGITS ) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if( mantissa != 0 )
+                numDigits++;
+        }
+        else
+            exponent++;     // dropped a digit before the point
+    }
+    
+    if( p < end && *p == '.' ) {
+        for( p++; p < end && isDigit(*p); p++ ) {
+            if( numDigits < CSV_MAX_MANTISSA_DIGITS ) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if( mantissa != 0 )
+                    numDigits++;
+                exponent--;
+            }
+        }
+    }
+    
+    if( p < end && (*p == 'e' || *p == 'E') ) {
+        p++;
+        bool bNegativeExp = false;
+        if( p < end && (*p == '-' || *p == '+') ) {
+            bNegativeExp = (*p == '-');
+            p++;
+        }
+        
+        int e = 0;
+        for( ; p < end && isDigit(*p); p++ ) {
+            if( e < 10000 )
+                e = e * 10 + (*p - '0');
+        }
+        
+        exponent += bNegativeExp ? -e : e;
+    }
+    
+    double value = (double)mantissa;
+    if( exponent < 0 )
+        value = (exponent >= -22) ? value / powersOf10[-exponent] : value * pow(10.0, exponent);
+    else if( exponent > 0 )
+        value = (exponent <= 22) ? value * powersOf10[exponent] : value * pow(10.0, exponent);
+    
+    return (float)(bNegative ? -value : value);
+}
+
+//-- moves past one cell, to the ',' or line break after it
+static inline const char *skipCell( const char *p, const char *end ) {
+    if( p < end && *p == '"' ) {
+        for( p++; p < end; p++ ) {
+            if( *p == '"' ) {
+                if( p + 1 < end && p[1] == '"' )
+                    p++;            // "" is an escaped quote
+                else {
+                    p++;
+                    break;
+                }
+            }
+        }
+    }
+    
+    while( p < end && *p != ',' && *p != '\n' && *p != '\r' )
+        p++;
+    
+    return p;
+}
+
+//-- moves to the start of the next line
+static inline const char *skipLine( const char *p, const char *end ) {
+    const char *eol = (const char *)memchr(p, '\n', end - p);
+    return (eol == NULL) ? end : eol + 1;
+}
+
+static inline bool isBlankLine( const char *p, const char *end ) {
+    return p < end && (*p == '\n' || *p == '\r');
+}
+
+bool readCSVColumns( const std::string &path, csvColumns &columns ) {
+    mappedFile file;
+    if( file.open(path) == false )
+        return false;
+    
+    const char *p = file.getData();
+    const char *end = p + file.getSize();
+    
+    columns.categories.clear();
+    columns.xs.clear();
+    columns.ys.clear();
+    columns.sizes.clear();
+    columns.numRows = 0;
+    
+    //-- rough guess so the arrays don't keep re-growing, they get trimmed at the end
+    unsigned long estRows = file.getSize() / CSV_EST_BYTES_PER_ROW + 1;
+    if( columns.categoryColumn != CSV_SKIP_COLUMN ) columns.categories.reserve(estRows);
+    if( columns.xColumn != CSV_SKIP_COLUMN ) columns.xs.reserve(estRows);
+    if( columns.yColumn != CSV_SKIP_COLUMN ) columns.ys.reserve(estRows);
+    if( columns.sizeColumn != CSV_SKIP_COLUMN ) columns.sizes.reserve(estRows);
+    
+    //-- skip header
+    if( p < end )
+        p = skipLine(p, end);
+    
+    while( p < end ) {
+        if( isBlankLine(p, end) ) {
+            p = skipLine(p, end);
+            continue;
+        }
+        
+        float category = 0, x = 0, y = 0, s = 0;
+        
+        for( int col = 0; ; col++ ) {
+            if( col == columns.categoryColumn )
+                category = parseCSVFloat(p, end);
+            else if( col == columns.xColumn )
+                x = parseCSVFloat(p, end);
+            else if( col == columns.yColumn )
+                y = parseCSVFloat(p, end);
+            else if( col == columns.sizeColumn )
+                s = parseCSVFloat(p, end);
+            
+            p = skipCell(p, end);
+            
+            if( p < end && *p == ',' )
+                p++;
+            else
+                break;
+        }
+        
+        if( columns.categoryColumn != CSV_SKIP_COLUMN ) columns.categories.push_back((int)category);
+        if( columns.xColumn != CSV_SKIP_COLUMN ) columns.xs.push_back(x);
+        if( columns.yColumn != CSV_SKIP_COLUMN ) columns.ys.push_back(y);
+        if( columns.sizeColumn != CSV_SKIP_COLUMN ) columns.sizes.push_back(s);
+        columns.numRows++;
+        
+        p = skipLine(p, end);
+    }
+    
+    columns.categories.shrink_to_fit();
+    columns.xs.shrink_to_fit();
+    columns.ys.shrink_to_fit();
+    columns.sizes.shrink_to_fit();
+    
+    return true;
+}
@@ -0,0 +1,47 @@
+/*********************************************************
+    csvColumnReader.h
+    Fast projected CSV loading for Data Crystals
+ 
+    Notes:
+    - memory-maps the file and parses only the columns we ask for,
+        straight into numeric arrays, no per-cell strings
+ 
+    - comma separated, first row is a header, LF or CRLF breaks,
+        blank lines are skipped, quoted fields may contain commas
+ 
+    - a missing or non-numeric cell reads as 0, like ofToFloat()
+**********************************************************/
+
+
+#ifndef __csvColumnReader__
+#define __csvColumnReader__
+
+#include <string>
+#include <vector>
+
+#define CSV_SKIP_COLUMN (-1)
+
+
+struct csvColumns {
+    //-- which columns to keep (0 = first), CSV_SKIP_COLUMN to leave one out
+    int categoryColumn = CSV_SKIP_COLUMN;
+    int xColumn = CSV_SKIP_COLUMN;
+    int yColumn = CSV_SKIP_COLUMN;
+    int sizeColumn = CSV_SKIP_COLUMN;
+    
+    //-- one entry per data row, only filled for the columns we keep
+    std::vector<int> categories;
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> sizes;
+    
+    unsigned long numRows = 0;
+};
+
+//-- parses every data row of the file at path, false if it can't be opened
+bool readCSVColumns( const std::string &path, csvColumns &columns );
+
+//-- the number parser readCSVColumns() uses, stops at the first character that isn't part of the number
+float parseCSVFloat( const char *p, const char *end );
+
+#endif /* defined(__csvColumnReader__) */
@@ -0,0 +1,36 @@
+/*********************************************************
+ cubeGeometry.cpp
+ Cube corner and triangle tables for Data Crystals
+ 
+ **********************************************************/
+
+#include "cubeGeometry.h"
+
+
+const int cubeTriangleCorners[CUBE_NUM_TRIANGLES][3] = {
+    { 0, 4, 6 }, { 0, 6, 2 },       // -x
+    { 1, 3, 7 }, { 1, 7, 5 },       // +x
+    { 0, 1, 5 }, { 0, 5, 4 },       // -y
+    { 2, 6, 7 }, { 2, 7, 3 },       // +y
+    { 0, 2, 3 }, { 0, 3, 1 },       // -z
+    { 4, 5, 7 }, { 4, 7, 6 }        // +z
+};
+
+const ofVec3f cubeTriangleNormals[CUBE_NUM_TRIANGLES] = {
+    ofVec3f(-1, 0, 0), ofVec3f(-1, 0, 0),
+    ofVec3f( 1, 0, 0), ofVec3f( 1, 0, 0),
+    ofVec3f( 0,-1, 0), ofVec3f( 0,-1, 0),
+    ofVec3f( 0, 1, 0), ofVec3f( 0, 1, 0),
+    ofVec3f( 0, 0,-1), ofVec3f( 0, 0,-1),
+    ofVec3f( 0, 0, 1), ofVec3f( 0, 0, 1)
+};
+
+void getCubeCorners( float x, float y, float z, float s, ofVec3f *corners ) {
+    float h = s / 2;
+    
+    for( int i = 0; i < CUBE_NUM_CORNERS; i++ ) {
+        corners[i].x = (i & 1) ? x + h : x - h;
+        corners[i].y = (i & 2) ? y + h : y - h;
+        corners[i].z = (i & 4) ? z + h : z - h;
+    }
+}
@@ -0,0 +1,33 @@
+/*********************************************************
+    cubeGeometry.h
+    Cube corner and triangle tables for Data Crystals
+ 
+    Notes:
+    - data only keep a center and an edge size, these turn that into
+        geometry when exporting
+ 
+    - corner i is at (x +/- s/2, y +/- s/2, z +/- s/2), with bit 0 of i
+        picking +x, bit 1 +y and bit 2 +z
+ 
+    - triangles wind counter-clockwise seen from outside the cube
+**********************************************************/
+
+
+#ifndef __cubeGeometry__
+#define __cubeGeometry__
+
+#include "ofMain.h"
+
+#define CUBE_NUM_CORNERS (8)
+#define CUBE_NUM_TRIANGLES (12)
+
+//-- corner indexes of each triangle, two per face in -x, +x, -y, +y, -z, +z order
+extern const int cubeTriangleCorners[CUBE_NUM_TRIANGLES][3];
+
+//-- outward normal of each triangle
+extern const ofVec3f cubeTriangleNormals[CUBE_NUM_TRIANGLES];
+
+//-- the 8 corners of a cube with edge s centered on (x, y, z)
+void getCubeCorners( float x, float y, float z, float s, ofVec3f *corners );
+
+#endif /* defined(__cubeGeometry__) */
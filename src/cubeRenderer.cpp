@@ -0,0 +1,211 @@
+/*********************************************************
+ cubeRenderer.cpp
+ Instanced cube drawing implementation for Data Crystals
+ 
+ The frustum planes come straight out of the model-view-projection
+ matrix, see clipSpace.h
+ 
+ **********************************************************/
+
+#include "cubeRenderer.h"
+#include "clipSpace.h"
+
+
+cubeRenderer::cubeRenderer() {
+    bInstanced = false;
+    modelScale = ofVec3f(1, 1, 1);
+    numInstances = 0;
+    maxCubeSize = 0;
+    bCullDirty = true;
+    lastPixelsPerUnit = 0;
+    bufferCapacity = 0;
+    pointCapacity = 0;
+}
+
+void cubeRenderer::setup() {
+    //-- unit cube centered on the origin, the shader scales and moves it
+    cubeMesh = ofMesh::box(1, 1, 1, 1, 1, 1);
+    cubeVbo.setMesh(cubeMesh, GL_STATIC_DRAW);
+    
+    bInstanced = shader.load("shaders/instancedCube") && pointShader.load("shaders/instancedPoint");
+    
+    if( bInstanced == false )
+        cout << "ERROR cubeRenderer::setup() couldn't load shaders/instancedCube or instancedPoint, drawing one cube at a time\n";
+}
+
+void cubeRenderer::update( const vector<ofVec3f> &positions, const vector<float> &sizes, const vector<ofColor> &colors,
+                           const vector<cubeGroup> &_groups ) {
+    numInstances = positions.size();
+    instances.resize(numInstances);
+    groups = _groups;
+    maxCubeSize = 0;
+    
+    for( unsigned long i = 0; i < numInstances; i++ ) {
+        cubeInstance &c = instances[i];
+        c.x = positions[i].x;
+        c.y = positions[i].y;
+        c.z = positions[i].z;
+        c.s = sizes[i];
+        c.r = colors[i].r / 255.0f;
+        c.g = colors[i].g / 255.0f;
+        c.b = colors[i].b / 255.0f;
+        c.a = 1.0f;
+        
+        if( c.s > maxCubeSize )
+            maxCubeSize = c.s;
+    }
+    
+    bCullDirty = true;
+}
+
+//-- re-packs the cubes and points that are in view, O(groups + what is drawn)
+void cubeRenderer::cull( const ofMatrix4x4 &mvp, float pixelsPerUnit ) {
+    float planes[NUM_FRUSTUM_PLANES][4];
+    getFrustumPlanes(mvp, planes);
+    
+    drawnCubes.clear();
+    drawnPoints.clear();
+    
+    float halfCube = maxCubeSize * 0.5f;
+    
+    for( unsigned long g = 0; g < groups.size(); g++ ) {
+        const cubeGroup &group = groups[g];
+        
+        //-- scaled box around the whole cubes, the scale is never negative
+        ofVec3f lo = ofVec3f(group.minCenter.x * modelScale.x, group.minCenter.y * modelScale.y, group.minCenter.z * modelScale.z);
+        ofVec3f hi = ofVec3f(group.maxCenter.x * modelScale.x, group.maxCenter.y * modelScale.y, group.maxCenter.z * modelScale.z);
+        
+        float cx = (lo.x + hi.x) * 0.5f, cy = (lo.y + hi.y) * 0.5f, cz = (lo.z + hi.z) * 0.5f;
+        float ex = (hi.x - lo.x) * 0.5f + halfCube, ey = (hi.y - lo.y) * 0.5f + halfCube, ez = (hi.z - lo.z) * 0.5f + halfCube;
+        
+        bool bInside = true;
+        for( int p = 0; p < NUM_FRUSTUM_PLANES && bInside; p++ ) {
+            float dist = planes[p][0] * cx + planes[p][1] * cy + planes[p][2] * cz + planes[p][3];
+            float radius = fabsf(planes[p][0]) * ex + fabsf(planes[p][1]) * ey + fabsf(planes[p][2]) * ez;
+            bInside = (dist >= -radius);
+        }
+        
+        if( bInside == false )
+            continue;
+        
+        //-- clip w is the distance in front of the camera, take the nearest the box gets
+        float radius = sqrtf(ex * ex + ey * ey + ez * ez);
+        float nearW = worldToClip(mvp, cx, cy, cz).w - radius;
+        
+        const cubeInstance *first = &instances[group.first];
+        
+        if( nearW > 0 && radius * 2.0f * pixelsPerUnit / nearW < LOD_GROUP_POINT_PIXELS ) {
+            // the whole group as one point, in the color of its first cube
+            cubeInstance proxy = *first;
+            proxy.x = (group.minCenter.x + group.maxCenter.x) * 0.5f;
+            proxy.y = (group.minCenter.y + group.maxCenter.y) * 0.5f;
+            proxy.z = (group.minCenter.z + group.maxCenter.z) * 0.5f;
+            proxy.s = radius * 2.0f;
+            drawnPoints.push_back(proxy);
+        }
+        else if( nearW > 0 && maxCubeSize * pixelsPerUnit / nearW < LOD_CUBE_POINT_PIXELS )
+            drawnPoints.insert(drawnPoints.end(), first, first + group.count);
+        else
+            drawnCubes.insert(drawnCubes.end(), first, first + group.count);
+    }
+    
+    //-- fallback, the points are a plain point mesh, drawing them as cubes of their size would make
+    //-- every distant group proxy a solid box as big as the whole group
+    if( bInstanced == false ) {
+        fallbackPoints.clear();
+        fallbackPoints.setMode(OF_PRIMITIVE_POINTS);
+        
+        for( unsigned long i = 0; i < drawnPoints.size(); i++ ) {
+            const cubeInstance &c = drawnPoints[i];
+            fallbackPoints.addVertex(ofVec3f(c.x * modelScale.x, c.y * modelScale.y, c.z * modelScale.z));
+            fallbackPoints.addColor(ofFloatColor(c.r, c.g, c.b, c.a));
+        }
+        return;
+    }
+    
+    //-- cubes are per instance attributes of the unit cube
+    if( uploadInstances(instanceBuffer, bufferCapacity, drawnCubes) ) {
+        int posSizeLoc = shader.getAttributeLocation("instancePosSize");
+        int colorLoc = shader.getAttributeLocation("instanceColor");
+        
+        cubeVbo.setAttributeBuffer(posSizeLoc, instanceBuffer, 4, sizeof(cubeInstance), 0);
+        cubeVbo.setAttributeBuffer(colorLoc, instanceBuffer, 4, sizeof(cubeInstance), 4 * sizeof(float));
+        cubeVbo.setAttributeDivisor(posSizeLoc, 1);
+        cubeVbo.setAttributeDivisor(colorLoc, 1);
+    }
+    
+    //-- points are plain vertices, w of the position is the size
+    if( uploadInstances(pointBuffer, pointCapacity, drawnPoints) ) {
+        pointVbo.setAttributeBuffer(ofShader::POSITION_ATTRIBUTE, pointBuffer, 4, sizeof(cubeInstance), 0);
+        pointVbo.setAttributeBuffer(ofShader::COLOR_ATTRIBUTE, pointBuffer, 4, sizeof(cubeInstance), 4 * sizeof(float));
+    }
+}
+
+//-- into buffer, true when it had to be re-allocated and the attributes need re-pointing at it
+bool cubeRenderer::uploadInstances( ofBufferObject &buffer, unsigned long &capacity, const vector<cubeInstance> &items ) {
+    if( items.size() == 0 )
+        return false;
+    
+    if( items.size() > capacity ) {
+        capacity = items.size();
+        buffer.allocate(capacity * sizeof(cubeInstance), items.data(), GL_DYNAMIC_DRAW);
+        return true;
+    }
+    
+    buffer.updateData(0, items.size() * sizeof(cubeInstance), items.data());
+    return false;
+}
+
+void cubeRenderer::draw( ofCamera &cam ) {
+    if( numInstances == 0 )
+        return;
+    
+    ofRectangle viewport = ofGetCurrentViewport();
+    ofMatrix4x4 mvp = cam.getModelViewProjectionMatrix(viewport);
+    
+    //-- pixels across for one unit at a distance of one unit
+    float pixelsPerUnit = viewport.height / (2.0f * tanf(ofDegToRad(cam.getFov()) * 0.5f));
+    
+    if( bCullDirty || isSameMatrix(mvp, lastMVP) == false ||
+        modelScale.x != lastScale.x || modelScale.y != lastScale.y || modelScale.z != lastScale.z ||
+        pixelsPerUnit != lastPixelsPerUnit ) {
+        cull(mvp, pixelsPerUnit);
+        
+        lastMVP = mvp;
+        lastScale = modelScale;
+        lastPixelsPerUnit = pixelsPerUnit;
+        bCullDirty = false;
+    }
+    
+    if( bInstanced ) {
+        if( drawnCubes.size() > 0 ) {
+            shader.begin();
+            shader.setUniform3f("modelScale", modelScale.x, modelScale.y, modelScale.z);
+            cubeVbo.drawElementsInstanced(GL_TRIANGLES, cubeVbo.getNumIndices(), drawnCubes.size());
+            shader.end();
+        }
+        
+        if( drawnPoints.size() > 0 ) {
+            glEnable(GL_PROGRAM_POINT_SIZE);
+            pointShader.begin();
+            pointShader.setUniform3f("modelScale", modelScale.x, modelScale.y, modelScale.z);
+            pointShader.setUniform1f("pixelsPerUnit", pixelsPerUnit);
+            pointVbo.draw(GL_POINTS, 0, drawnPoints.size());
+            pointShader.end();
+            glDisable(GL_PROGRAM_POINT_SIZE);
+        }
+        return;
+    }
+    
+    //-- fallback, one draw call per cube, and the points in one go
+    for( unsigned long i = 0; i < drawnCubes.size(); i++ ) {
+        cubeInstance &c = drawnCubes[i];
+        ofSetColor(c.r * 255, c.g * 255, c.b * 255);
+        ofDrawBox(ofVec3f(c.x * modelScale.x, c.y * modelScale.y, c.z * modelScale.z), c.s);
+    }
+    
+    if( drawnPoints.size() > 0 ) {
+        ofSetColor(255, 255, 255);
+        fallbackPoints.draw();
+    }
+}
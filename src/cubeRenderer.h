@@ -0,0 +1,112 @@
+/*********************************************************
+    cubeRenderer.h
+    Instanced cube drawing for Data Crystals
+    
+    Notes:
+    - one shared unit-cube mesh plus a per-instance buffer of
+        position, size and color, drawn with a single call
+    
+    - needs the programmable (GL 3.2) renderer, see main.cpp, and
+        the shaders in bin/data/shaders/instancedCube.* and instancedPoint.*
+    
+    - cubes come in groups (one per cluster) with the bounds of their
+        centers, groups outside the camera frustum aren't drawn at all
+    
+    - level of detail: a group whose cubes would be only a few pixels
+        is drawn as one point sprite per cube, a whole group that would
+        be only a few pixels is one point sprite for the group
+    
+    - what is drawn is re-packed into the GL buffers only when the camera,
+        the scale or the cubes change, so frame time follows what is on
+        screen rather than the size of the dataset
+    
+    - falls back to one ofDrawBox() per cube, and a plain point mesh for
+        the points, if the shaders won't load
+**********************************************************/
+
+
+#ifndef __cubeRenderer__
+#define __cubeRenderer__
+
+#include "ofMain.h"
+
+//-- smaller than this on screen, in pixels, and cubes are points, and groups are a single point
+#define LOD_CUBE_POINT_PIXELS (3.0f)
+#define LOD_GROUP_POINT_PIXELS (4.0f)
+
+
+//-- cubes [first, first + count) and the box around their centers, unscaled
+struct cubeGroup {
+    unsigned long first;
+    unsigned long count;
+    ofVec3f minCenter;
+    ofVec3f maxCenter;
+};
+
+
+class cubeRenderer  {
+
+public:
+    cubeRenderer();
+    
+    //-- needs a GL context
+    void setup();
+    
+    //-- copies the cubes in, only call when they change, the cubes of each group have to be contiguous
+    void update( const vector<ofVec3f> &positions, const vector<float> &sizes, const vector<ofColor> &colors,
+                 const vector<cubeGroup> &groups );
+    
+    //-- scales the cube centers (not the cubes), applied when drawing, so changing it costs nothing per cube
+    void setModelScale( const ofVec3f &scale ) { modelScale = scale; }
+    
+    //-- the cubes and points in view of cam, call between cam.begin() and cam.end()
+    void draw( ofCamera &cam );
+    
+    unsigned long getNumInstances() { return numInstances; }
+    unsigned long getNumDrawnCubes() { return drawnCubes.size(); }
+    unsigned long getNumDrawnPoints() { return drawnPoints.size(); }
+
+private:
+    //-- what we send per cube or point, matches instancePosSize + instanceColor in the shaders
+    struct cubeInstance {
+        float x, y, z, s;
+        float r, g, b, a;
+    };
+    
+    bool bInstanced;
+    ofVec3f modelScale;
+    
+    ofMesh cubeMesh;
+    ofVbo cubeVbo;
+    ofShader shader;
+    
+    ofVbo pointVbo;
+    ofShader pointShader;
+    
+    //-- the points when there are no shaders, rebuilt by cull()
+    ofVboMesh fallbackPoints;
+    
+    //-- every cube, grouped, and the cube size of the biggest one
+    vector<cubeInstance> instances;
+    vector<cubeGroup> groups;
+    unsigned long numInstances;
+    float maxCubeSize;
+    
+    //-- what is in view, re-packed by cull() when anything changes
+    vector<cubeInstance> drawnCubes;
+    vector<cubeInstance> drawnPoints;
+    bool bCullDirty;
+    ofMatrix4x4 lastMVP;
+    ofVec3f lastScale;
+    float lastPixelsPerUnit;
+    
+    ofBufferObject instanceBuffer;
+    unsigned long bufferCapacity;
+    ofBufferObject pointBuffer;
+    unsigned long pointCapacity;
+    
+    void cull( const ofMatrix4x4 &mvp, float pixelsPerUnit );
+    bool uploadInstances( ofBufferObject &buffer, unsigned long &capacity, const vector<cubeInstance> &items );
+};
+
+#endif /* defined(__cubeRenderer__) */
@@ -9,7 +9,12 @@
 
 
 #include "dataCrystalsApp.h"
-#include "ofxCsv.h"
+#include "distanceKernel.h"
+#include "datasetCache.h"
+#include "stlWriter.h"
+#include "meshWriter.h"
+#include <chrono>
+#include <assert.h>
 
 #define CATEGORY_TYPE_COLUMN_NUM (1)
 #define POINT_X_COLUMN_NUM (2)
@@ -17,15 +22,75 @@
 #define SIZE_COLUMN_NUM (4)
 
 
+#define CLUSTER_CHUNK_SIZE (4096)       // data per job in makeClusters()
+#define BATCH_REPORT_CYCLES (1000)      // console status every n cycles in batch mode
+#define SNAPSHOT_INTERVAL_MS (10)       // min time between snapshots from the simulation thread
+#define SIMULATION_IDLE_MS (5)          // simulation thread sleep when not clustering
+#define LOAD_CHUNK_ROWS (16384)         // rows filled per snapshot while loading
+#define GRAV_RESYNC_CYCLES (256)        // cycles between full recounts of the gravity center sum
+
+//-- requestLoad() types
+#define LOAD_NONE (0)
+#define LOAD_FILE (1)                   // the current file, from disk (or its cache)
+#define LOAD_CATEGORY (2)               // dataCategory of the current file, from memory if it is loaded
+#define LOAD_RELOAD (3)                 // 'r', from disk, then recolor
+
+
 #define CLUSTER_DRAW_X  (20)            // offset from left of screen
 #define CLUSTER_DRAW_Y (200)            // offset from bottom of screen
 #define CLUSTER_DRAW_Y_INCREMENT (18)   // amount between each line
 
 //--------------------------------------------------------------
 void dataCrystalsApp::setup(){
+    initVars();
+    
+    //-- GL
+    cubes.setup();
+    
+    //-- GUI
+    drawFont.loadFont("verdana.ttf",14 );
+    initGui();
+    
+    //-- DATA
+    generateTreeString();
+    
+    listCSVFiles();
+    
+    //-- display strings
+    formGUIStrings();
+    
+    //-- go full screen
+    ofToggleFullscreen();
+    
+    //-- clustering runs on its own thread from here on, draw() only sees snapshots
+    countParentsAndChildren();
+    publishSnapshot(true);
+    startSimulation();
+    
+    //-- the first file shows up as it loads, the window is already drawing
+    currentFileIndex = 0;
+    requestLoad(LOAD_FILE);
+}
+
+//--------------------------------------------------------------
+void dataCrystalsApp::exit(){
+    stopSimulation();
+}
+
+//-- headless version of setup(), no GL, no GUI and no data loaded yet, see batchMain.cpp
+void dataCrystalsApp::setupBatch() {
+    initVars();
+    initSettings();
+    
+    listCSVFiles();
+}
+
+void dataCrystalsApp::initVars() {
     //-- INSTANCE VARS
-    data = NULL;
     numData  = 0;
+    numVisible = 0;
+    visibleStart = 0;
+    visibleEnd = 0;
     bHideGui = false;
     bClustering = false;
     bShowClusterStatus = true;
@@ -33,36 +98,42 @@ void dataCrystalsApp::setup(){
     bUseColor = true;
     bAllLoaded = false;
     bUseSizeColumn = false;
+    exportFormat = "stl";
     numClusterCycles = 0;
     numChildren = 0;
     numParents = 0;
-    nextClusterID = 1;
-
+    numUnattached = 0;
+    
+    bSimulationRunning = false;
+    pendingLoad = LOAD_NONE;
+    bLoading = false;
+    loadEnd = 0;
+    frontSnapshot = 0;
+    lastSnapshotTime = 0;
+    snapshotVersion = 0;
+    drawnSnapshotVersion = 0;
+    
     gravCenter.x = 0;
     gravCenter.y = 0;
     gravCenter.z = 0;
+    gravSumX = 0;
+    gravSumY = 0;
+    gravSumZ = 0;
     
     gravRatio = .9;
     
     maxUnattachedSize = DEFAULT_CUBE_SIZE;
     
-    //-- GUI
-    drawFont.loadFont("verdana.ttf",14 );
-    initGui();
+    initColorPalette();
     
     //-- DATA
     minDataCategory = 1;
     maxDataCategory = 10;
     dataCategory = minDataCategory;
-    generateTreeString();
     
-    loadCSVFiles();
-    
-    //-- display strings
-    formGUIStrings();
-    
-    //-- go full screen
-    ofToggleFullscreen();
+    //-- one cluster thread per core
+    clusterThreads.setup();
+    cout << "cluster threads = " << clusterThreads.getNumThreads() << ", distance kernel = " << getDistanceKernelName() << "\n";
 }
 
 //--------------------------------------------------------------
@@ -76,70 +147,342 @@ void dataCrystalsApp::update(){
 void dataCrystalsApp::draw(){
     ofShowCursor();
     
+    //-- the simulation thread only swaps in a new snapshot when it can get this without waiting
+    std::lock_guard<std::mutex> snapshotLock(snapshotMutex);
+    crystalSnapshot &snapshot = snapshots[frontSnapshot];
+    
+    //-- only re-upload the instances when the simulation has moved something
+    if( snapshot.version != drawnSnapshotVersion ) {
+        cubes.update(snapshot.positions, snapshot.sizes, snapshot.colors, snapshot.groups);
+        labels.update(snapshot.labelPositions, snapshot.labels);
+        drawnSnapshotVersion = snapshot.version;
+    }
+    
     ofSetColor(255,255,255);
     cam.begin();
     
+    //-- positions are unscaled, the sliders are applied here, and in makeClusters() and saveMesh()
+    ofVec3f modelScale = getModelScale();
+    cubes.setModelScale(modelScale);
+    cubes.draw(cam);
     
-    if( bClustering) {
-        
-        makeClusters();
-        findGravCenter();
+    cam.end();
+    
+    //-- screen space, one batched mesh, see labelRenderer
+    if( bDrawClusterIDs ) {
+        labels.setModelScale(modelScale);
+        labels.draw(cam);
+    }
+    
+    if( !bHideGui )
+        gui.draw();
+    
+    if( bShowClusterStatus )
+        drawClusterStatus();
+    
+    
+    ofShowCursor();
+}
+
+void dataCrystalsApp::startSimulation() {
+    if( bSimulationRunning )
+        return;
+    
+    bSimulationRunning = true;
+    simulationThread = std::thread(&dataCrystalsApp::simulationLoop, this);
+}
+
+void dataCrystalsApp::stopSimulation() {
+    if( bSimulationRunning == false )
+        return;
+    
+    bSimulationRunning = false;
+    simulationThread.join();
+}
+
+//-- simulation thread: cycles as fast as it can while clustering, independent of the frame rate
+void dataCrystalsApp::simulationLoop() {
+    while( bSimulationRunning ) {
+        int request = pendingLoad.exchange(LOAD_NONE);
+        if( request != LOAD_NONE ) {
+            runLoad(request);
+            continue;
+        }
         
-        for( unsigned long i = 0; i < numData; i++ ) {
-            //-- move unattached and leaders
-            if( (data+i)->isChild() == true && (data+i)->getParent() == NULL )
-                ;   // cout << "no parent\n";
-            else if( (data+i)->isChild() == false )
-                (data+i)->jiggle(jigglePct, maxUnattachedSize, gravCenter, gravRatio );
+        if( bClustering == false ) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(SIMULATION_IDLE_MS));
+            continue;
         }
         
-        numClusterCycles++;
+        //-- the UI thread holds this while it reloads, recolors or saves
+        std::lock_guard<std::mutex> simLock(simMutex);
+        
+        // keyPressed() may have stopped us while we were waiting
+        if( bClustering == false )
+            continue;
         
-        //--
-        if( numUnattached == 0 && numParents == 1 )
-            bClustering =  false;
+        clusterCycle();
+        countParentsAndChildren();
         
-        //-- step-by-step test
-        //bClustering = false;
+        bool bDone = (numUnattached == 0 && numParents == 1);
+        if( bDone )
+            bClustering = false;
+        
+        //-- always show the final crystal
+        publishSnapshot(bDone);
     }
+}
+
+//-- copies what draw() needs into the back snapshot and swaps it to the front,
+//-- caller must hold simMutex (or be the simulation thread)
+void dataCrystalsApp::publishSnapshot( bool bForce ) {
+    uint64_t now = ofGetElapsedTimeMillis();
     
-    countParentsAndChildren();
+    //-- no point in copying faster than we can draw
+    if( bForce == false && now - lastSnapshotTime < SNAPSHOT_INTERVAL_MS )
+        return;
     
+    crystalSnapshot &back = snapshots[1 - frontSnapshot];
+    back.positions.clear();
+    back.sizes.clear();
+    back.colors.clear();
+    back.labelPositions.clear();
+    back.labels.clear();
     
-    for( unsigned long i = 0; i < numData; i++ ) {
-        if( (data+i)->visible )
-            (data+i)->draw();
+    back.groups.clear();
+    
+    //-- one group per cluster, members next to each other, so cubeRenderer can cull and LOD whole clusters
+    ofVec3f loc;
+    for( unsigned long root = visibleStart; root < visibleEnd; root++ ) {
+        if( clusters.find(root) != root )
+            continue;
+        
+        cubeGroup group;
+        group.first = back.positions.size();
+        group.count = 0;
+        
+        for( unsigned long i = root; i != CLUSTER_SET_END; i = clusters.getNextMember(i) ) {
+            getWorldLoc(i, loc);
+            back.positions.push_back(loc);
+            back.sizes.push_back(DEFAULT_CUBE_SIZE);
+            back.colors.push_back(colorPalette[data.getColorIndex(i)]);
+            
+            if( group.count == 0 )
+                group.minCenter = group.maxCenter = loc;
+            else {
+                group.minCenter.x = MIN(group.minCenter.x, loc.x);
+                group.minCenter.y = MIN(group.minCenter.y, loc.y);
+                group.minCenter.z = MIN(group.minCenter.z, loc.z);
+                group.maxCenter.x = MAX(group.maxCenter.x, loc.x);
+                group.maxCenter.y = MAX(group.maxCenter.y, loc.y);
+                group.maxCenter.z = MAX(group.maxCenter.z, loc.z);
+            }
+            group.count++;
+            
+            if( bDrawClusterIDs && isTopLevel(i) ) {
+                back.labelPositions.push_back(loc);
+                back.labels.push_back(clusters.getLabel(i));
+            }
+        }
+        
+        back.groups.push_back(group);
     }
+    
+    snapshotVersion++;
+    back.version = snapshotVersion;
+    back.numClusterCycles = numClusterCycles;
+    back.numUnattached = numUnattached;
+    back.numParents = numParents;
+    back.numChildren = numChildren;
+    back.maxUnattachedSize = maxUnattachedSize;
+    back.numVisible = numVisible;
+    back.numData = numData;
+    back.numToLoad = bLoading ? loadEnd - visibleStart : 0;
+    
+    //-- never wait on draw(), just try again next cycle
+    if( bForce )
+        snapshotMutex.lock();
+    else if( snapshotMutex.try_lock() == false )
+        return;
+    
+    frontSnapshot = 1 - frontSnapshot;
+    snapshotMutex.unlock();
+    
+    lastSnapshotTime = now;
+}
+
+//-- hands a load to the simulation thread, so the window keeps drawing while it happens,
+//-- a newer request replaces one that hasn't finished
+void dataCrystalsApp::requestLoad( int request ) {
+    bClustering = false;
+    bLoading = true;
+    pendingLoad = request;
+}
 
+//-- simulation thread side of requestLoad(), the file is parsed without holding simMutex, then the
+//-- visible range is filled a chunk at a time, publishing each chunk, so points appear as they load
+void dataCrystalsApp::runLoad( int request ) {
+    string filename;
+    bool bFromDisk;
+    bool bAllFiles;
     
-    if( bDrawClusterIDs) {
-        for( unsigned long i = 0; i < numData; i++ ) {
-            if( (data +i)->isTopLevel() ) {
-                ofVec3f v;
-                (data+i)->getLoc(v);
-                sprintf(clusterString, "%lu", (unsigned long)(data+i)->getClusterID());
-                
-                v.x += 20;
-                v.y += 20;
-                v.z += 20;
-                
-                ofDrawBitmapString(clusterString, v );
+    {
+        std::lock_guard<std::mutex> simLock(simMutex);
+        
+        bAllFiles = (request == LOAD_RELOAD && bAllLoaded);
+        
+        if( bAllFiles == false ) {
+            if( numCSVFiles == 0 ) {
+                bLoading = false;
+                return;
             }
+            
+            filename = csvFiles[currentFileIndex].getFileName();
+            bFromDisk = (request != LOAD_CATEGORY || loadedColumnsFile != filename);
         }
     }
     
-    if( data )
+    //-- every file, parsed in parallel without the lock, then filled in one go under it,
+    //-- so there are no chunks to show along the way
+    if( bAllFiles ) {
+        vector<csvColumns> parsedFiles;
+        parseAllFiles(parsedFiles);
         
-    cam.end();
+        std::lock_guard<std::mutex> simLock(simMutex);
+        
+        //-- keyPressed() asked for something else while we were parsing
+        if( pendingLoad != LOAD_NONE )
+            return;
+        
+        fillAllData(parsedFiles);
+        
+        if( bUseColor )
+            applyColorToAll();
+        else
+            applyColor();
+        
+        bLoading = false;
+        countParentsAndChildren();
+        publishSnapshot(true);
+        return;
+    }
     
-    if( !bHideGui )
-        gui.draw();
+    csvColumns csv;
+    bool bRead = (bFromDisk == false || readInputFile(filename, csv));
     
-    if( bShowClusterStatus )
-        drawClusterStatus();
+    ofVec3f average;
     
+    {
+        std::lock_guard<std::mutex> simLock(simMutex);
+        
+        //-- keyPressed() asked for something else while we were parsing
+        if( pendingLoad != LOAD_NONE )
+            return;
+        
+        //-- keeps whatever was loaded before
+        if( bRead == false ) {
+            bLoading = false;
+            return;
+        }
+        
+        if( bFromDisk )
+            setLoadedColumns(filename, csv);
+        
+        beginCategory(average);
+        
+        loadEnd = visibleEnd;
+        visibleEnd = visibleStart;
+        numVisible = 0;
+        
+        if( loadEnd == visibleStart )
+            bLoading = false;
+        
+        countParentsAndChildren();
+        publishSnapshot(true);
+    }
     
-    ofShowCursor();
+    bool bDone = (visibleEnd == loadEnd);
+    while( bDone == false ) {
+        std::lock_guard<std::mutex> simLock(simMutex);
+        
+        if( pendingLoad != LOAD_NONE || bSimulationRunning == false )
+            return;
+        
+        unsigned long chunkEnd = visibleEnd + LOAD_CHUNK_ROWS;
+        if( chunkEnd > loadEnd )
+            chunkEnd = loadEnd;
+        
+        numVisible += fillCSVRows(loadedColumns, 0, visibleEnd, chunkEnd, average);
+        visibleEnd = chunkEnd;
+        
+        bDone = (visibleEnd == loadEnd);
+        if( bDone ) {
+            if( request == LOAD_RELOAD )
+                applyColor();
+            
+            bLoading = false;
+        }
+        
+        countParentsAndChildren();
+        publishSnapshot(bDone);
+    }
+}
+
+//-- one simulation step: bind what is in range, then move the unattached and leaders
+void dataCrystalsApp::clusterCycle() {
+    //-- once per cycle, the sliders can move while we go
+    ofVec3f modelScale = getModelScale();
+    makeClusters(modelScale);
+    
+    //-- the running sum drifts a little with every move, so start again from the data now and then
+    if( numClusterCycles % GRAV_RESYNC_CYCLES == 0 )
+        resyncGravSum();
+    
+    findGravCenter();
+    
+    float cycleJigglePct = jigglePct;
+    float cycleGravRatio = gravRatio;
+    
+    for( unsigned long i = visibleStart; i < visibleEnd; i++ ) {
+        //-- move unattached and leaders
+        if( isChild(i) == false ) {
+            unsigned long root = clusters.find(i);
+            unsigned long setIndex = clusters.getSetIndex(root);
+            
+            //-- unattached, the datum itself moves
+            if( setIndex == CLUSTER_SET_END ) {
+                ofVec3f step(0, 0, 0);
+                data.jiggle(i, cycleJigglePct, maxUnattachedSize, gravCenter, cycleGravRatio, modelScale, step );
+                data.adjust(i, step.x, step.y, step.z);
+                continue;
+            }
+            
+            ofVec3f &offset = setOffsets[setIndex];
+            ofVec3f lastOffset = offset;
+            
+            data.jiggle(i, cycleJigglePct, maxUnattachedSize, gravCenter, cycleGravRatio, modelScale, offset );
+            
+            //-- every member of a cluster moved by the same amount
+            addToGravSum(offset - lastOffset, clusters.getSize(root));
+        }
+    }
+    
+    numClusterCycles++;
+}
+
+//-- batch mode: cycle as fast as we can until there is a single crystal (or we give up), returns the cycle count
+unsigned long dataCrystalsApp::clusterToConvergence( unsigned long maxCycles ) {
+    countParentsAndChildren();
+    
+    while( isClusterDone() == false && numClusterCycles < maxCycles ) {
+        clusterCycle();
+        countParentsAndChildren();
+        
+        if( numClusterCycles % BATCH_REPORT_CYCLES == 0 )
+            cout << "cycles = " << numClusterCycles << ", unattached = " << numUnattached << ", parents = " << numParents << "\n";
+    }
+    
+    return numClusterCycles;
 }
 
 //-- go through all and check to see if:
@@ -153,34 +496,107 @@ void dataCrystalsApp::draw(){
 //  (2) is part of the same cluster
 //          (a) is parent (or grandparent)
 //          (b) is child (or grandchild)
-//          **(c) optimize this by using a cluster id instead of a traversal each time??
+//          (c) checked with the clusterSet (union-find), no traversal
 //
 //
-//  (3)
+//  (3) is outside the 27 grid cells around (i), never tested, see spatialGrid
+//
+//  Pairs are found in parallel against the clusters as they were at the start of the
+//  cycle, then bound serially in index order, so each cycle is reproducible
 //
 //-------------------------------------------------------------------------------------------------
-void dataCrystalsApp::makeClusters() {
-    for( unsigned long i = 0; i < numData; i++ ) {
-        if( (data+i)->visible == false )
-            continue;
-        
-        //-- this is unattached, so we can check all
-        for( unsigned long j = 0; j < numData; j++ ) {
-            if( (data+j)->visible == false)
+void dataCrystalsApp::makeClusters( const ofVec3f &modelScale ) {
+    //-- snapshot of the cluster roots as each datum's cluster ID, find() compresses paths so the workers
+    //-- can't call it
+    for( unsigned long i = visibleStart; i < visibleEnd; i++ )
+        data.setClusterID(i, clusters.find(i));
+    
+    //-- positions have moved since the last jiggle(), so re-bin everything
+    //-- the slider is read once, the workers have to test the same distance the grid was built for
+    float minClusterDist = DEFAULT_CUBE_SIZE * clusterPct;
+    float minClusterDistSq = minClusterDist * minClusterDist;
+    
+    //-- world positions are scaled by the sliders, so distances are measured in the crystal as drawn,
+    //-- the grid keeps the only copy of them, in bucket order
+    clusterGrid.build([this, &modelScale](unsigned long i, ofVec3f &loc) {
+        data.getLoc(i, loc);
+        loc += getSetOffset(data.getClusterID(i));
+        loc *= modelScale;
+    }, visibleStart, visibleEnd, minClusterDist);
+    
+    // 1st phase: find candidate pairs in parallel, one buffer per chunk of the visible data
+    unsigned long numChunks = (visibleEnd - visibleStart + CLUSTER_CHUNK_SIZE - 1) / CLUSTER_CHUNK_SIZE;
+    if( bindPairs.size() < numChunks )
+        bindPairs.resize(numChunks);
+    
+    threadRanges.resize(clusterThreads.getNumThreads());
+    threadHits.resize(clusterThreads.getNumThreads());
+    
+    clusterThreads.run(numChunks, [this, minClusterDistSq](unsigned long chunk, int threadIndex) {
+        findBindPairs(chunk, threadIndex, minClusterDistSq);
+    });
+    
+    // 2nd phase: bind serially, in chunk (i.e. data index) order, so the result doesn't depend on the threads
+    for( unsigned long c = 0; c < numChunks; c++ ) {
+        for( unsigned long p = 0; p < bindPairs[c].size(); p++ ) {
+            unsigned long d1 = bindPairs[c][p].first;
+            unsigned long d2 = bindPairs[c][p].second;
+            
+            //-- an earlier pair this cycle may have already joined them
+            if( inSameCluster(d1, d2) )
                 continue;
+            
+            bindClusters( d1, d2 );
+        }
+    }
+}
+
+//-- worker side of makeClusters(), only reads data, writes to bindPairs[chunk]
+void dataCrystalsApp::findBindPairs( unsigned long chunk, int threadIndex, float minClusterDistSq ) {
+    vector< pair<unsigned long, unsigned long> > &chunkPairs = bindPairs[chunk];
+    vector< pair<unsigned long, unsigned long> > &ranges = threadRanges[threadIndex];
+    vector<unsigned long> &hits = threadHits[threadIndex];
+    chunkPairs.clear();
+    
+    unsigned long start = visibleStart + chunk * CLUSTER_CHUNK_SIZE;
+    unsigned long end = start + CLUSTER_CHUNK_SIZE;
+    if( end > visibleEnd )
+        end = visibleEnd;
+    
+    const uint32_t *entries = clusterGrid.getEntries();
+    const float *entryX = clusterGrid.getEntryX();
+    const float *entryY = clusterGrid.getEntryY();
+    const float *entryZ = clusterGrid.getEntryZ();
+    
+    for( unsigned long i = start; i < end; i++ ) {
+        //-- only the neighboring cells can be in cluster distance
+        unsigned long self = clusterGrid.getEntryOf(i);
+        ofVec3f loc(entryX[self], entryY[self], entryZ[self]);
+        clusterGrid.getNeighborRanges(loc, ranges);
         
-            if( i == j )
-                continue;   // skip self
+        bool bFound = false;
+        for( unsigned long r = 0; r < ranges.size() && bFound == false; r++ ) {
+            unsigned long first = ranges[r].first;
             
-            if( inSameCluster(data+i, data+j) )
-                continue;
+            //-- distance test for the whole bucket at once
+            hits.clear();
+            findWithinDistance( loc.x, loc.y, loc.z,
+                                entryX + first, entryY + first, entryZ + first, ranges[r].second - first,
+                                minClusterDistSq, hits );
             
-            if( inClusterDistance(data+i, data+j) ) {
-                bindClusters( data+i, data+j );
+            for( unsigned long h = 0; h < hits.size(); h++ ) {
+                unsigned long j = entries[first + hits[h]];
+                
+                if( i == j )
+                    continue;   // skip self
+                
+                if( data.getClusterID(i) == data.getClusterID(j) )
+                    continue;   // same cluster, as of the start of this cycle
+                
+                chunkPairs.push_back(make_pair(i, j));
+                bFound = true;
                 break;  // done with this one, exit loop
             }
-            
-            //-- end for(j loop)
         }
        
         //-- end main loop (for i loop_
@@ -188,133 +604,170 @@ void dataCrystalsApp::makeClusters() {
 }
 
 //-- when two are in the same cluster distance and have been cross-checked
-void dataCrystalsApp::bindClusters( datum *d1, datum *d2) {
+void dataCrystalsApp::bindClusters( unsigned long d1, unsigned long d2) {
     //-- this two countParentsAndChildren() are just in for debugging purposes
    // countParentsAndChildren();
    
-    datum * topParent = d1->getTopParent();         // top node of Dd1
+    unsigned long topParent = clusters.getTop(d1);       // top node of Dd1
     
     attachToCluster(topParent, d2);
     //countParentsAndChildren();
 }
 
 //-- attach two clusters, the main cluster will contain the parent and keep its cluster ID
-void dataCrystalsApp::attachToCluster(datum *subCluster, datum *mainCluster) {
-    //-- unattached, give it a new cluster ID
-    if( mainCluster->getClusterID() == 0 ) {
-        mainCluster->setClusterID(nextClusterID);
-        nextClusterID++;
+//-- the clusterSet keeps the parent/child tree: main's top stays the top of the merged cluster
+void dataCrystalsApp::attachToCluster(unsigned long subCluster, unsigned long mainCluster) {
+    unsigned long subRoot = clusters.find(subCluster);
+    unsigned long mainRoot = clusters.find(mainCluster);
+    
+    unsigned long subSize = clusters.getSize(subRoot);
+    unsigned long mainSize = clusters.getSize(mainRoot);
+    
+    //-- anything that was unattached is now clustered and counts toward the gravity center,
+    //-- the rest keep their world positions
+    ofVec3f subOffset = getSetOffset(subRoot);
+    ofVec3f mainOffset = getSetOffset(mainRoot);
+    
+    ofVec3f loc;
+    if( subSize == 1 ) {
+        getWorldLoc(subCluster, loc);
+        addToGravSum(loc, 1);
     }
-
-    subCluster->setClusterID(mainCluster->getClusterID());
-    mainCluster->addChild(subCluster);
-    subCluster->setParent(mainCluster);
+    if( mainSize == 1 ) {
+        getWorldLoc(mainCluster, loc);
+        addToGravSum(loc, 1);
+    }
+    
+    //-- the clusterSet hands out a new cluster ID if main is unattached
+    unsigned long newRoot = clusters.unite(subCluster, mainCluster);
+    
+    //-- every bind makes one more child (the top of sub), and leaves one parent where there were
+    //-- up to two, unattached falls out of countParentsAndChildren()
+    numChildren++;
+    numParents++;
+    if( subSize > 1 )
+        numParents--;
+    if( mainSize > 1 )
+        numParents--;
+    
+    //-- two unattached make a new set, which starts at rest (a set index can be one that was freed)
+    unsigned long setIndex = clusters.getSetIndex(newRoot);
+    if( setIndex >= setOffsets.size() )
+        setOffsets.resize(setIndex + 1);
+    if( subSize == 1 && mainSize == 1 )
+        setOffsets[setIndex] = ofVec3f(0, 0, 0);
+    
+    //-- the absorbed set now moves with the new root's offset, so rebase its members to keep their
+    //-- world positions, union by size keeps this to the smaller set
+    unsigned long oldRoot = (newRoot == mainRoot) ? subRoot : mainRoot;
+    ofVec3f rebase = ((oldRoot == subRoot) ? subOffset : mainOffset) - setOffsets[setIndex];
+    
+    for( unsigned long m = oldRoot; m != CLUSTER_SET_END; m = clusters.getNextMember(m) )
+        data.adjust(m, rebase.x, rebase.y, rebase.z);
  //   cout << "exit\n";
  
 }
 
 
-//-- only count clustered ones
+//-- only count clustered ones, from the running sum, see addToGravSum()
 void dataCrystalsApp::findGravCenter() {
-    unsigned long numClustered = 0;
+    unsigned long numClustered = numParents + numChildren;
     
     gravCenter.x = 0;
     gravCenter.y = 0;
     gravCenter.z = 0;
     
-    ofVec3f tv;
-    for( unsigned long i = 0; i < numData; i++ ) {
-        if( (data+i)->isUnattached() )
-            continue;
-        
-        (data+i)->getLoc(tv);
-        
-        gravCenter += tv;
-        numClustered++;
-        
-        //cout << tv << "\n";
+    if( numClustered > 0 ) {
+        gravCenter.x = gravSumX / numClustered;
+        gravCenter.y = gravSumY / numClustered;
+        gravCenter.z = gravSumZ / numClustered;
     }
     
-    if( numClustered > 0 )
-        gravCenter /= numClustered;
-    
     //cout << "grav center: " << gravCenter << "\n";
 }
 
-bool dataCrystalsApp::inSameCluster( datum *d1, datum *d2 ) {
-    if( d1->getClusterID() == 0 || d2->getClusterID() == 0)
-        return false;
-    
-    return (d1->getClusterID() == d2->getClusterID());
+//-- sum of the world positions of every clustered datum, kept in doubles to slow the drift
+void dataCrystalsApp::addToGravSum( const ofVec3f &loc, unsigned long count ) {
+    gravSumX += (double)loc.x * count;
+    gravSumY += (double)loc.y * count;
+    gravSumZ += (double)loc.z * count;
 }
 
-bool dataCrystalsApp::inClusterDistance( datum *d1, datum *d2 ) {
-    ofVec3f v1, v2;
-    
-    /*
-    float totalSize = d1->getSize() + d2->getSize();
-    float minClusterDist = (totalSize/2) * clusterPct;
-    
-    float shortestSize = (d1->getSize() < d2->getSize()) ? d1->getSize() : d2->getSize();
-    if( shortestSize < 3 && (d1->getSize() != d2->getSize()) )
-        cout << "\n";
+//-- the full O(N) pass, every GRAV_RESYNC_CYCLES cycles
+void dataCrystalsApp::resyncGravSum() {
+    gravSumX = 0;
+    gravSumY = 0;
+    gravSumZ = 0;
     
-    minClusterDist = shortestSize * clusterPct;
-     */
-    
-    float minClusterDist = DEFAULT_CUBE_SIZE * clusterPct;
-    
-    
-    d1->getLoc(v1);
-    d2->getLoc(v2);
+    ofVec3f tv;
+    for( unsigned long i = visibleStart; i < visibleEnd; i++ ) {
+        if( isUnattached(i) )
+            continue;
+        
+        getWorldLoc(i, tv);
+        addToGravSum(tv, 1);
+    }
+}
+
+//-- offset of the set root is the root of, zero when unattached, safe from the workers
+const ofVec3f &dataCrystalsApp::getSetOffset( unsigned long root ) {
+    static const ofVec3f atRest(0, 0, 0);
     
-    if( v1.distance(v2)  < minClusterDist)
-        return true;
-    else
-        return false;
+    unsigned long setIndex = clusters.getSetIndex(root);
+    return (setIndex == CLUSTER_SET_END) ? atRest : setOffsets[setIndex];
+}
+
+//-- position + cluster offset, not thread-safe (find() compresses paths)
+void dataCrystalsApp::getWorldLoc( unsigned long i, ofVec3f &loc ) {
+    data.getLoc(i, loc);
+    loc += getSetOffset(clusters.find(i));
+}
+
+bool dataCrystalsApp::inSameCluster( unsigned long d1, unsigned long d2 ) {
+    return clusters.same(d1, d2);
+}
+
+//-- parent/child status, the clusterSet knows each cluster's size and top-level datum
+bool dataCrystalsApp::isUnattached( unsigned long i ) {
+    return clusters.getSize(i) == 1;
+}
+
+bool dataCrystalsApp::isChild( unsigned long i ) {
+    return clusters.getSize(i) > 1 && clusters.getTop(i) != i;
 }
 
+bool dataCrystalsApp::isTopLevel( unsigned long i ) {
+    return clusters.getSize(i) > 1 && clusters.getTop(i) == i;
+}
+
+//-- numParents and numChildren are kept up to date by attachToCluster() and resetClusters(),
+//-- so this is O(1), every visible datum is exactly one of unattached, child or parent
 void dataCrystalsApp::countParentsAndChildren() {
-    numChildren = 0;       // instance var, num children
-    numParents = 0;       // instance car, num parents
-    
-    maxUnattachedSize = 0;
+    numUnattached = numVisible - (numParents + numChildren);
     
-    if( maxUnattachedSize == 0 )
+    //-- every cube is DEFAULT_CUBE_SIZE, so the largest unattached one is too, if there are any
+    //-- only true while the size column is off (datumStore keeps no sizes, see the 'z' key), turning it
+    //-- back on needs a histogram of the unattached sizes here instead
+    assert(bUseSizeColumn == false);
+    if( numUnattached > 0 )
+        maxUnattachedSize = DEFAULT_CUBE_SIZE;
+    else
         maxUnattachedSize = 2;
+}
+
+//-- every datum back in its own cluster, at rest
+void dataCrystalsApp::resetClusters() {
+    clusters.reset(numData);
+    setOffsets.clear();
     
-    //cout << "\n-- count --\n";
-    
-    //-- count parents & children
-    for( unsigned long i = 0; i < numData; i++ ) {
-        if( (data+i)->visible == false )
-            continue;
-        
-        if( (data+i)->isUnattached() )
-            maxUnattachedSize = ((data+i)->getSize() > maxUnattachedSize ) ? (data+i)->getSize() : maxUnattachedSize;
-        
-        if( (data+i)->isChild() ) {
-            numChildren++;
-            
-      //      cout << "child: " << (data+i)->id << " [" << (data+i)->getParent()->id << "]" << "\n";
-            
-            
-        }
-        else if( (data+i)->hasChildren() ) {
-            numParents++;
-        //     cout << "parent: " << (data+i)->id << "\n";
-            
-        }
-    
-    }
-    
+    numParents = 0;
+    numChildren = 0;
     
-    numUnattached = numVisible - (numParents + numChildren);
-
-    // OLD
-    //numUnattached = numData - (numParents + numChildren);
-
+    gravSumX = 0;
+    gravSumY = 0;
+    gravSumZ = 0;
 }
+
 void dataCrystalsApp::drawClusterStatus() {
     ofSetColor(0,255,0);
     makeClusterDisplayStrings();
@@ -333,16 +786,22 @@ void dataCrystalsApp::drawClusterStatus() {
     
     drawY+= CLUSTER_DRAW_Y_INCREMENT;
     ofDrawBitmapString(numChildrenString, ofPoint(CLUSTER_DRAW_X, drawY) );
-
+    
     drawY+= CLUSTER_DRAW_Y_INCREMENT;
     ofDrawBitmapString(numDataString, ofPoint(CLUSTER_DRAW_X, drawY) );
     
     drawY += CLUSTER_DRAW_Y_INCREMENT;
     ofDrawBitmapString(maxUnattachedSizeString, ofPoint(CLUSTER_DRAW_X, drawY) );
-
+    
+    drawY += CLUSTER_DRAW_Y_INCREMENT;
+    ofDrawBitmapString(numDrawnString, ofPoint(CLUSTER_DRAW_X, drawY) );
+    
     drawY+= CLUSTER_DRAW_Y_INCREMENT;
     ofDrawBitmapString(sizeOnString, ofPoint(CLUSTER_DRAW_X, drawY) );
     
+    drawY+= CLUSTER_DRAW_Y_INCREMENT;
+    ofDrawBitmapString(exportFormatString, ofPoint(CLUSTER_DRAW_X, drawY) );
+    
     ofSetColor(255,255,255);
     drawY+= CLUSTER_DRAW_Y_INCREMENT;
     ofDrawBitmapString(treeDisplayStr, ofPoint(CLUSTER_DRAW_X, drawY) );
@@ -351,15 +810,22 @@ void dataCrystalsApp::drawClusterStatus() {
 
 
 
+//-- counters come from the front snapshot, draw() holds snapshotMutex
 void dataCrystalsApp::makeClusterDisplayStrings()
 {
-    sprintf(numVisibleString, "num visible = %lu", numVisible);
-    sprintf(numUnattachedStr, "num unattached = %lu", numUnattached);
-    sprintf(numClusterCyclesStr, "cycles = %lu", numClusterCycles);
-    sprintf(numParentsString, "num parents = %lu", numParents);
-    sprintf(numChildrenString, "num children = %lu", numChildren);
-    sprintf(numDataString, "num data = %lu", numData);
-    sprintf(maxUnattachedSizeString, "max unnatached size = %d", maxUnattachedSize);
+    crystalSnapshot &snapshot = snapshots[frontSnapshot];
+    
+    if( snapshot.numToLoad > 0 )
+        sprintf(numVisibleString, "loading = %lu / %lu", snapshot.numVisible, snapshot.numToLoad);
+    else
+        sprintf(numVisibleString, "num visible = %lu", snapshot.numVisible);
+    sprintf(numUnattachedStr, "num unattached = %lu", snapshot.numUnattached);
+    sprintf(numClusterCyclesStr, "cycles = %lu", snapshot.numClusterCycles);
+    sprintf(numParentsString, "num parents = %lu", snapshot.numParents);
+    sprintf(numChildrenString, "num children = %lu", snapshot.numChildren);
+    sprintf(numDataString, "num data = %lu", snapshot.numData);
+    sprintf(maxUnattachedSizeString, "max unnatached size = %d", snapshot.maxUnattachedSize);
+    sprintf(numDrawnString, "drawn cubes = %lu, points = %lu", cubes.getNumDrawnCubes(), cubes.getNumDrawnPoints());
 }
 
 void dataCrystalsApp::formGUIStrings() {
@@ -368,6 +834,8 @@ void dataCrystalsApp::formGUIStrings() {
     else
         strcpy(sizeOnString, "use size column = false");
     
+    sprintf(exportFormatString, "export format = %s", exportFormat.c_str());
+    
     strcpy( fileDisplayStr, "\n");
     //(char *)csvFiles[currentFileIndex].getFileName() );
     
@@ -419,6 +887,9 @@ void dataCrystalsApp::generateTreeString() {
 
 //--------------------------------------------------------------
 void dataCrystalsApp::keyPressed(int key){
+    //-- wait for the current simulation step, everything below can touch the data
+    std::lock_guard<std::mutex> simLock(simMutex);
+    
     if( key == 'g' ) {
         bHideGui = !bHideGui;
         bShowClusterStatus = !bShowClusterStatus;
@@ -429,6 +900,26 @@ void dataCrystalsApp::keyPressed(int key){
     else if( key == 's' ) {
         saveMesh();
     }
+    else if( key == 'S' ) {
+        saveMergedMesh();
+    }
+    else if( key == 'x' ) {
+        saveMeshAs(false);
+    }
+    else if( key == 'X' ) {
+        saveMeshAs(true);
+    }
+    else if( key == 'e' ) {
+        // next export format
+        if( exportFormat == "stl" )
+            exportFormat = "ply";
+        else if( exportFormat == "ply" )
+            exportFormat = "obj";
+        else
+            exportFormat = "stl";
+        
+        formGUIStrings();
+    }
     
     else if( key == 'c' ) {
         bUseColor = !bUseColor;
@@ -452,8 +943,8 @@ void dataCrystalsApp::keyPressed(int key){
         
         generateTreeString();
         
-        // this will reload the entire data file, resetting the positions of everythng
-        loadCSVFiles();
+        // resets the positions of everything in the new category
+        requestLoad(LOAD_CATEGORY);
         
     }
     else if( key == '2' ) {
@@ -468,20 +959,20 @@ void dataCrystalsApp::keyPressed(int key){
         
         generateTreeString();
         
-        // this will reload the entire data file, resetting the positions of everything
-        loadCSVFiles();
+        // resets the positions of everything in the new category
+        requestLoad(LOAD_CATEGORY);
     }
     
     else if( key == 'a' ) {
         bClustering = false;
         bAllLoaded = true;
         
-        // this will reload the entire data file, resetting the positions of everything
-        loadCSVFiles();
+        // every category of the loaded file, resetting the positions of everything
+        requestLoad(LOAD_CATEGORY);
         
         generateTreeString();
     }
-
+    
     
     //-- old file-indexing code
     /*
@@ -491,7 +982,7 @@ void dataCrystalsApp::keyPressed(int key){
         if( currentFileIndex == numCSVFiles )
             currentFileIndex = 0;
         
-        loadCSVData(csvFiles[currentFileIndex].getFileName(), NULL, currentFileIndex );
+        loadCSVData(csvFiles[currentFileIndex].getFileName());
         
         applyColor();
         bAllLoaded = false;
@@ -503,7 +994,7 @@ void dataCrystalsApp::keyPressed(int key){
         if( currentFileIndex == -1 )
             currentFileIndex = numCSVFiles - 1;
         
-        loadCSVData(csvFiles[currentFileIndex].getFileName(), NULL, currentFileIndex );
+        loadCSVData(csvFiles[currentFileIndex].getFileName());
         
         applyColor();
         bAllLoaded = false;
@@ -518,15 +1009,7 @@ void dataCrystalsApp::keyPressed(int key){
     */
     
     else if( key == 'r' ) {
-        if( bAllLoaded )
-            loadAllData();
-        else
-            loadCSVData(csvFiles[currentFileIndex].getFileName(), NULL, currentFileIndex );
-        
-        if( bAllLoaded && bUseColor )
-            applyColorToAll();
-        else
-            applyColor();
+        requestLoad(LOAD_RELOAD);
     }
     
     //-- not supported now
@@ -537,7 +1020,7 @@ void dataCrystalsApp::keyPressed(int key){
         if( bAllLoaded )
             loadAllData();
         else
-            loadCSVData(csvFiles[currentFileIndex].getFileName(), NULL, currentFileIndex );
+            loadCSVData(csvFiles[currentFileIndex].getFileName());
         
         if( bAllLoaded && bUseColor )
             applyColorToAll();
@@ -551,20 +1034,25 @@ void dataCrystalsApp::keyPressed(int key){
     else if( key == ' ' ) {
         bClustering = !bClustering;
         
+        // nothing to cluster until the data is in
+        if( bLoading )
+            bClustering = false;
+        
         // can't cluster if we are done
         if( bClustering && numUnattached == 0 && numParents == 1 )
             bClustering = false;
     }
-//    else if( key == '9') {
-//        bDrawClusterIDs = !bDrawClusterIDs;
-//    }
+    else if( key == '9') {
+        bDrawClusterIDs = !bDrawClusterIDs;
+    }
+    
+    //-- reloads, colors and cluster state all show up in the next frame
+    countParentsAndChildren();
+    publishSnapshot(true);
 }
 
 
-/*
- Load each CSV file here, or cycle to the next one
- */
-void dataCrystalsApp::loadCSVFiles() {
+void dataCrystalsApp::listCSVFiles() {
     //-- load files into vector array
     ofDirectory dir(ofToDataPath("input"));
     numCSVFiles = dir.listDir();
@@ -574,74 +1062,174 @@ void dataCrystalsApp::loadCSVFiles() {
     
     csvFiles = dir.getFiles();
     
+    //-- made here, once, since loadAllData() reads files from several threads
+    ofDirectory::createDirectory("cache/", true);
+    
     for(int i=0; i< numCSVFiles; ++i)
         cout <<  "Index Num: " << i << " — Filename: " << csvFiles[i].getFileName() << endl;
-    
-    //-- load first CSV - will crash if we have no CSV files
+}
+
+//-- batch mode: load one file from input/ for one category, or every file at once (empty filename),
+//-- another category of the file already loaded comes from its columns, as with '1' and '2'
+void dataCrystalsApp::loadBatchData( string filename, int category ) {
+    bClustering = false;
+    numClusterCycles = 0;
+    dataCategory = category;
     currentFileIndex = 0;
-    loadCSVData(csvFiles[currentFileIndex].getFileName(), NULL, currentFileIndex);
-    //applyColor();
+    
+    if( filename.empty() ) {
+        bAllLoaded = true;
+        loadAllData();
+    }
+    else if( filename == loadedColumnsFile ) {
+        bAllLoaded = false;
+        
+        ofVec3f average;
+        beginCategory(average);
+        numVisible = fillCSVRows(loadedColumns, 0, visibleStart, visibleEnd, average);
+    }
+    else {
+        bAllLoaded = false;
+        loadCSVData(filename);
+    }
+    
+    countParentsAndChildren();
 }
 
 
+//-- parses a file from input/, just the columns we use, expects a comma-delimted file with a header row, or its binary cache
+bool dataCrystalsApp::readInputFile(string filename, csvColumns &csv) {
+    string path = ofToDataPath("input/");
+    path.append(filename);
+    
+    csv.categoryColumn = CATEGORY_TYPE_COLUMN_NUM;
+    csv.xColumn = POINT_X_COLUMN_NUM;
+    csv.yColumn = POINT_Y_COLUMN_NUM;
+    //if( bUseSizeColumn )
+    //    csv.sizeColumn = SIZE_COLUMN_NUM;
+    
+    //-- parsed columns are cached in cache/, the text is only parsed again when the CSV changes
+    string cachePath = ofToDataPath("cache/");
+    cachePath.append(filename);
+    cachePath.append(".bin");
+    
+    if( readDatasetCache(cachePath, path, csv) )
+        return true;
+    
+    if( readCSVColumns(path, csv) == false ) {
+        cout << "ERROR readInputFile() can't open " << path << "\n";
+        return false;
+    }
+    
+    if( writeDatasetCache(cachePath, path, csv) == false )
+        cout << "WARNING readInputFile() can't write cache " << cachePath << "\n";
+    
+    return true;
+}
 
-unsigned long dataCrystalsApp::loadCSVData(string filename, datum *dataPtr, int fileIndex) {
-    float latTotal = 0;
-    float lngTotal = 0;
-    float heightTotal = 0;
+//-- loads the whole file before returning, see runLoad() for the background version
+unsigned long dataCrystalsApp::loadCSVData(string filename) {
     numVisible = 0;
     
     loadedFilename = filename;
+    
+    csvColumns csv;
+    if( readInputFile(filename, csv) == false )
+        return 0;
+    
+    unsigned long csvDataRows = csv.numRows;
+    setLoadedColumns(filename, csv);
+    
+    ofVec3f average;
+    beginCategory(average);
+    
+    cout << "X avg = " << average.x << "\n";
+    cout << "Y avg = " << average.y << "\n";
+    cout << "Z avg = " << average.z << "\n";
+    
+    numVisible = fillCSVRows(loadedColumns, 0, visibleStart, visibleEnd, average);
+    
+    return csvDataRows;
+}
+
+//-- sorts a parsed file by category, allocates data for it and keeps the columns,
+//-- so switching categories doesn't need the file again
+void dataCrystalsApp::setLoadedColumns(string filename, csvColumns &csv) {
+    unsigned long csvDataRows = csv.numRows;
+    
+    sortColumnsByCategory(csv);
+    
+    numData = csvDataRows;
+    data.reset(numData);
+    
+    manifest.clear();
+    manifest.push_back(datasetFile(filename, 0, csvDataRows));
+    
+    std::swap(loadedColumns, csv);
+    loadedColumnsFile = filename;
+    
+    // display strings
+    loadedFilename = filename;
+    numDataPointsStr = makePointsStr(csvDataRows);
+}
 
-    // Generate pathname into CSV diretor and load into an ofxCsv object, expects a TAB-delimted file,
-    // with LF breaks
-    wng::ofxCsv csv;
-    string path = ofToDataPath("input/");
-    path.append(filename);
-    csv.loadFile(path, ",");
+//-- unclusters everything and picks dataCategory's range of the loaded file, which the caller fills in,
+//-- the data outside that range are never looked at
+void dataCrystalsApp::beginCategory(ofVec3f &average) {
+    numClusterCycles = 0;
+    resetClusters();
+    
+    getCSVAverage(loadedColumns, average);
     
-    //-- skip header
-    unsigned long csvDataRows = csv.numRows - 1;
+    setVisibleRange();
+}
 
-    // this will allocate a new buffer of data from the current CSV file
-    if( dataPtr == NULL ) {
-        if( data )
-            delete [] data;
+//-- turns one parsed file into data, centered on its own average, returns how many are visible
+//-- only writes to its own range of data, so files can be filled from different threads
+unsigned long dataCrystalsApp::fillCSVData(csvColumns &csv, unsigned long dataOffset, ofVec3f &average) {
+    getCSVAverage(csv, average);
     
-        numData = csvDataRows;
-        data = new datum[numData];
-        
-        dataPtr = data;
+    return fillCSVRows(csv, dataOffset, 0, csv.numRows, average);
+}
+
+//-- the average of the positions fillCSVRows() sets, taken over the whole file
+void dataCrystalsApp::getCSVAverage(csvColumns &csv, ofVec3f &average) {
+    unsigned long csvDataRows = csv.numRows;
+    
+    float xTotal = 0;
+    float yTotal = 0;
+    float zTotal = 0;
+    
+    for( unsigned long i = 0; i < csvDataRows; i++ ) {
+        xTotal += csv.xs[i] * (1/20.0f);
+        yTotal += csv.ys[i] * (1/20.0f);
         
-    }
-    else {
-        cout << "non-null\n";
+        if( bAllLoaded )
+            zTotal += (float)(csv.categories[i] * 1000) * (1/20.f);
     }
     
-    // start at i = 0 to skip header
+    // This can be cleaned up once we figure out static operators
+    
+//    datum::latAvg = latTotal/(numData*2);
+//    datum::lonAvg = lngTotal/(numData*2);
+    
+    average = ofVec3f(xTotal/csvDataRows, yTotal/csvDataRows, zTotal/csvDataRows);
+}
 
-    float pointX, pointY, pointZ, s;
+//-- (re)builds rows [start, end) of a parsed file as fresh, unclustered data, returns how many are visible,
+//-- the file's first row is data index dataOffset
+unsigned long dataCrystalsApp::fillCSVRows(csvColumns &csv, unsigned long dataOffset, unsigned long start, unsigned long end, const ofVec3f &average) {
+    unsigned long numRowsVisible = 0;
+    
+    float pointX, pointY, pointZ;
     int categoryID;
-    unsigned short r,g,b;
     
-    // 1st pass: read in CSV, set raw points
-    for( unsigned long i = 1; i < csvDataRows+1; i++ ) {
-        
-        categoryID = ofToInt(csv.data[i][CATEGORY_TYPE_COLUMN_NUM]);
-        pointX = ofToFloat(csv.data[i][POINT_X_COLUMN_NUM]);
-        pointY = ofToFloat(csv.data[i][POINT_Y_COLUMN_NUM]);
+    for( unsigned long i = start; i < end; i++ ) {
+        categoryID = csv.categories[i];
+        pointX = csv.xs[i];
+        pointY = csv.ys[i];
         
-        /*
-        if( bUseSizeColumn ) {
-            s = ofToFloat(csv.data[i][SIZE_COLUMN_NUM]);
-            if( s == 0 )
-                s = DEFAULT_CUBE_SIZE;
-            
-            (dataPtr+i-1)->setSize(s);
-        }
-        */
-        
-        (dataPtr+i-1)->setCategoryType(categoryID);
+        //-- the size column isn't stored, every cube is DEFAULT_CUBE_SIZE, see datumStore
         
         //cout << "category id = " << categoryID << "\n";
         
@@ -650,162 +1238,173 @@ unsigned long dataCrystalsApp::loadCSVData(string filename, datum *dataPtr, int
         else
             pointZ = 0;
         
-        // index - 1 for data but [i] for CSV array since we are skipping the header
-        (dataPtr+i-1)->setValues(   pointX,
-                                    pointY,
-                                    pointZ,
-                                    xScale/20.0f,
-                                    xScale/20.0f,
-                                    zScale/20.f);
+        //-- scaled, then centered on the file's average, the sliders aren't applied here, see getModelScale()
+        data.set(   dataOffset + i,
+                    pointX * (1/20.0f) - average.x,
+                    pointY * (1/20.0f) - average.y,
+                    pointZ * (1/20.f) - average.z,
+                    categoryID );
         
         //-- use categoryIDs instead of colors
-        getColorFromFileIndex(categoryID,r,g,b);
-        (dataPtr+i-1)->setColor(r,g,b);
-        
-        //-- turn off visibilty of those not in category
-        if( bAllLoaded == false  ) {
-            if( categoryID == dataCategory ) {
-                (dataPtr+i-1)->visible = true;
-                numVisible++;
-            }
-            else {
-                (dataPtr+i-1)->visible = false;
-            }
-        }
-        else {
-            (dataPtr+i-1)->visible = true;
-            numVisible++;
-        }
+        data.setColorIndex(dataOffset + i, getColorIndex(categoryID));
+        
+        //-- only the current category is shown, the visible range has nothing else in it
+        if( bAllLoaded || categoryID == dataCategory )
+            numRowsVisible++;
     }
     
-    csv.clear();
+    return numRowsVisible;
+}
+
+//-- stable sort of every kept column by category, so each category is one contiguous range of rows
+void dataCrystalsApp::sortColumnsByCategory(csvColumns &csv) {
+    categoryRanges.clear();
     
-    float xTotal = 0;
-    float yTotal = 0;
-    float zTotal = 0;
+    //-- count each category, then turn the counts into start offsets
+    for( unsigned long i = 0; i < csv.numRows; i++ )
+        categoryRanges[csv.categories[i]].second++;
     
-    // 2nd pass: calculate averages for x, y and z
-    for( unsigned long i = 0; i < csvDataRows; i++ ) {
-        xTotal += (dataPtr+i)->getX();
-        yTotal += (dataPtr+i)->getY();
-        zTotal += (dataPtr+i)->getZ();
+    unsigned long offset = 0;
+    for( std::map<int, pair<unsigned long, unsigned long> >::iterator it = categoryRanges.begin(); it != categoryRanges.end(); ++it ) {
+        unsigned long count = it->second.second;
+        it->second.first = offset;
+        it->second.second = offset;     // used as the fill position below, ends up as the end
+        offset += count;
     }
     
-    float avgX = xTotal/csvDataRows;
-    float avgY = yTotal/csvDataRows;
-    float avgZ = zTotal/csvDataRows;
-    
-    // This can be cleaned up once we figure out static operators
+    //-- scatter, in row order
+    csvColumns sorted;
+    sorted.categoryColumn = csv.categoryColumn;
+    sorted.xColumn = csv.xColumn;
+    sorted.yColumn = csv.yColumn;
+    sorted.sizeColumn = csv.sizeColumn;
+    sorted.numRows = csv.numRows;
+    sorted.categories.resize(csv.categories.size());
+    sorted.xs.resize(csv.xs.size());
+    sorted.ys.resize(csv.ys.size());
+    sorted.sizes.resize(csv.sizes.size());
+    
+    for( unsigned long i = 0; i < csv.numRows; i++ ) {
+        unsigned long j = categoryRanges[csv.categories[i]].second++;
+        
+        sorted.categories[j] = csv.categories[i];
+        if( csv.xs.empty() == false )
+            sorted.xs[j] = csv.xs[i];
+        if( csv.ys.empty() == false )
+            sorted.ys[j] = csv.ys[i];
+        if( csv.sizes.empty() == false )
+            sorted.sizes[j] = csv.sizes[i];
+    }
     
-//    datum::latAvg = latTotal/(numData*2);
-//    datum::lonAvg = lngTotal/(numData*2);
+    std::swap(csv, sorted);
+}
 
-    cout << "X avg = " << avgX << "\n";
-    cout << "Y avg = " << avgY << "\n";
-    cout << "Z avg = " << avgZ << "\n";
+//-- the range the hot loops walk: everything, or the current category of the loaded file
+void dataCrystalsApp::setVisibleRange() {
+    visibleStart = 0;
+    visibleEnd = numData;
     
-    // 3nd pass: make adjustments averages for x, y and z
-    for( unsigned long i = 0; i < csvDataRows; i++ ) {
-        (dataPtr+i)->adjustValues( -avgX, -avgY, -avgZ );
-        
-        //(data+i)->scaleValues( 1.0/20.0, 1.0/20.0, 1.0/20.0);
-        
-//        (dataPtr+i)->setClusterPct(.5);
-        
-        // the ID will be a problem...
-        (dataPtr+ i)->id = i;
+    if( bAllLoaded )
+        return;
+    
+    std::map<int, pair<unsigned long, unsigned long> >::iterator it = categoryRanges.find(dataCategory);
+    if( it == categoryRanges.end() ) {
+        visibleEnd = 0;     // nothing in this category
+        return;
     }
-
-    // display strings
-    loadedFilename = filename;
-    numDataPointsStr = makePointsStr(csvDataRows);
     
-    return csvDataRows;
+    visibleStart = it->second.first;
+    visibleEnd = it->second.second;
 }
 
+//-- every file in input/, each parsed once, the manifest records where each one lands in data
+//-- files are parsed, then filled into their own ranges, in parallel on clusterThreads
 void dataCrystalsApp::loadAllData() {
-    // Step 1: count all rows in all CSV files
-    numData = 0;
+    vector<csvColumns> parsedFiles;
+    parseAllFiles(parsedFiles);
+    fillAllData(parsedFiles);
+}
+
+//-- Step 1: parse all CSV files, only the columns we use are kept, touches no data so doesn't need simMutex
+void dataCrystalsApp::parseAllFiles( vector<csvColumns> &parsedFiles ) {
+    parsedFiles.assign(numCSVFiles, csvColumns());
     
-    wng::ofxCsv csv;
+    clusterThreads.run(numCSVFiles, [this, &parsedFiles](unsigned long fileIndex, int) {
+        readInputFile(csvFiles[fileIndex].getFileName(), parsedFiles[fileIndex]);
+    });
+}
+
+//-- Steps 2-4, the parsed files are freed as they are used
+void dataCrystalsApp::fillAllData( vector<csvColumns> &parsedFiles ) {
+    // Step 2: lay the files out back to back, allocate the data
+    numData = 0;
+    manifest.clear();
     
-    currentFileIndex = 0;
     for( int i = 0; i < numCSVFiles; i++ ) {
-        string path = ofToDataPath("input/");
-        path.append(csvFiles[i].getFileName());
-        csv.loadFile(path, ",");
-        
-        //-- skip header
-        numData += (csv.numRows - 1);
+        manifest.push_back(datasetFile(csvFiles[i].getFileName(), numData, parsedFiles[i].numRows));
+        numData += parsedFiles[i].numRows;
         
-        cout << "num this data = " << (csv.numRows - 1) << "\n";
+        cout << "num this data = " << parsedFiles[i].numRows << "\n";
     }
     
-    // Step 2: allocate the data
-    
-    
     cout << "num total data = " << numData << "\n";
-    if( data )
-        delete [] data;
-    
-    
-    data = new datum[numData];
+    data.reset(numData);
+    resetClusters();
     
-    datum *dataPtr = data;
-    unsigned long dataOffset = 0;
-    unsigned long numCSVRows;
+    // Step 3: fill in each file's range, each file is centered on its own average
+    vector<unsigned long> fileVisible(numCSVFiles, 0);
+    vector<ofVec3f> fileAverages(numCSVFiles);
     
-    for( int i = 0; i < numCSVFiles; i++ ) {
-        // Load each file
-        currentFileIndex = i;
-        numCSVRows = loadCSVData(csvFiles[currentFileIndex].getFileName(), (dataPtr+dataOffset), currentFileIndex);
-        dataOffset += numCSVRows;
-        
+    clusterThreads.run(numCSVFiles, [this, &parsedFiles, &fileVisible, &fileAverages](unsigned long fileIndex, int) {
+        unsigned long fileOffset = manifest[fileIndex].offset;
+        unsigned long numCSVRows = manifest[fileIndex].numRows;
         
-        //-- Make data adjustmetns on each set
-        datum *lastDataPtr = dataPtr + (dataOffset - numCSVRows);
+        fileVisible[fileIndex] = fillCSVData(parsedFiles[fileIndex], fileOffset, fileAverages[fileIndex]);
         
-        unsigned short r, g, b;
+        //-- done with this one, free it now rather than at the end
+        parsedFiles[fileIndex] = csvColumns();
         
-        getColorFromFileIndex(currentFileIndex,r,g,b);
+        //-- Make data adjustmetns on each set
+        int colorIndex = getColorIndex(fileIndex);
         
-        for( int j = 0; j < numCSVRows; j++ ) {
-            (lastDataPtr + j)->setColor(r,g,b);
+        for( unsigned long j = fileOffset; j < fileOffset + numCSVRows; j++ ) {
+            data.setColorIndex(j, colorIndex);
             
-            (lastDataPtr + j)->adjustValues(0,0, currentFileIndex * 50 * zScale);
+            data.adjust(j, 0,0, fileIndex * 50);
         }
-    }
-}
-
-void dataCrystalsApp::applyColorToAll() {
-    // Step 1: count all rows in all CSV files
-    unsigned long startIndex = 0;
-    unsigned long endIndex = 0;
-    unsigned long numCSVRows;
-    datum *dataPtr = data;
+    });
     
-    wng::ofxCsv csv;
+    // Step 4: merge the per-file results, files aren't sorted by category, everything is shown
+    numVisible = 0;
+    visibleStart = 0;
+    visibleEnd = numData;
     
-    unsigned short r, g, b;
+    categoryRanges.clear();
+    loadedColumns = csvColumns();
+    loadedColumnsFile.clear();
     
-    currentFileIndex = 0;
     for( int i = 0; i < numCSVFiles; i++ ) {
-        string path = ofToDataPath("input/");
-        path.append(csvFiles[i].getFileName());
-        csv.loadFile(path, ",");
+        numVisible += fileVisible[i];
         
-        //-- skip header
-        numCSVRows = (csv.numRows - 1);
+        cout << manifest[i].filename << " avg = " << fileAverages[i].x << ", " << fileAverages[i].y << ", " << fileAverages[i].z << "\n";
+    }
+    
+    //-- '1', '2' and 'a' go back to the first file, as they did when they reloaded it
+    currentFileIndex = 0;
+}
 
-        endIndex = startIndex + numCSVRows;
+//-- colors each file's range from the manifest, no need to go back to the files
+void dataCrystalsApp::applyColorToAll() {
+    currentFileIndex = 0;
+    for( size_t i = 0; i < manifest.size(); i++ ) {
+        unsigned long startIndex = manifest[i].offset;
+        unsigned long endIndex = startIndex + manifest[i].numRows;
         
-        getColorFromFileIndex(i,r,g,b);
+        int colorIndex = getColorIndex(i);
         
-        for( int j = startIndex; j < endIndex; j++ ) {
-            (dataPtr + j)->setColor(r,g,b);
+        for( unsigned long j = startIndex; j < endIndex; j++ ) {
+            data.setColorIndex(j, colorIndex);
         }
-        
-        startIndex = endIndex;
     }
 }
 
@@ -866,15 +1465,31 @@ void dataCrystalsApp::getColorFromFileIndex(int fileIndex, unsigned short &r, un
 
 //-- goes through all data points, applies color (or unapplies) from the current index
 void dataCrystalsApp::applyColor() {
-    unsigned short r = 255;
-    unsigned short g = 255;
-    unsigned short b = 255;
+    int colorIndex = DATUM_COLOR_WHITE;
     
     if( bUseColor )
-        getColorFromFileIndex(currentFileIndex,r,g,b);
+        colorIndex = getColorIndex(currentFileIndex);
+    
+    for( unsigned long i = 0; i < numData; i++ ) {
+        data.setColorIndex(i, colorIndex);
+    }
+}
+
+//-- data only keep an index into colorPalette, anything past the palette is white
+int dataCrystalsApp::getColorIndex(int fileIndex) {
+    if( fileIndex < 0 || fileIndex >= DATUM_COLOR_WHITE )
+        return DATUM_COLOR_WHITE;
+    
+    return fileIndex;
+}
+
+//-- one color per index, from getColorFromFileIndex()
+void dataCrystalsApp::initColorPalette() {
+    unsigned short r, g, b;
     
-    for( int i = 0; i < numData; i++ ) {
-        (data + i)->setColor(r,g,b);
+    for( int i = 0; i < NUM_PALETTE_COLORS; i++ ) {
+        getColorFromFileIndex(i, r, b, g);
+        colorPalette[i] = ofColor(r, g, b);
     }
 }
 
@@ -885,18 +1500,85 @@ std::string dataCrystalsApp::makePointsStr(unsigned long value) {
 }
 
 
-void dataCrystalsApp::saveMesh() {
-    ofxSTLExporter stlExporter;
+//-- STL is streamed straight from the data, see stlWriter, PLY and OBJ are indexed, see meshWriter
+void dataCrystalsApp::saveMesh( string path ) {
+    if( path.empty() )
+        path = "outputs/dataCrystal." + exportFormat;
+    
+    ofVec3f modelScale = getModelScale();
+    
+    //-- cluster roots up front, find() compresses paths so the export threads can't call it
+    for( unsigned long i = visibleStart; i < visibleEnd; i++ )
+        data.setClusterID(i, clusters.find(i));
+    
+    unsigned long first = visibleStart;
+    
+    //-- scale moves the centers (the GUI scale sliders), the cubes keep their size
+    stlCubeSource getCube = [this, first, modelScale](unsigned long n, ofVec3f &center, float &size) {
+        unsigned long i = first + n;
+        
+        data.getLoc(i, center);
+        center += getSetOffset(data.getClusterID(i));
+        center *= modelScale;
+        size = DEFAULT_CUBE_SIZE;
+    };
+    
+    if( ofToLower(ofFilePath::getFileExt(path)) == "stl" ) {
+        saveCubesSTL(ofToDataPath(path), "dataCrystal", visibleEnd - visibleStart, getCube, &clusterThreads);
+        return;
+    }
+    
+    indexedMesh mesh;
+    buildCubesMesh(visibleEnd - visibleStart, getCube, mesh);
+    
+    if( saveMeshFile(ofToDataPath(path), "dataCrystal", mesh) )
+        cout << path << ": " << mesh.vertices.size() << " vertices, " << mesh.getNumTriangles() << " triangles\n";
+}
 
-    stlExporter.beginModel("dataCrystal");
+//-- the visible cubes voxelised into one watertight surface, for printing, see voxelGrid
+void dataCrystalsApp::saveMergedMesh( string path, int voxelResolution ) {
+    if( path.empty() )
+        path = "outputs/dataCrystalMerged." + exportFormat;
     
-    for( unsigned long i = 0; i < numData; i++ ) {
-        if( (data+i)->visible )
-            (data+i)->save(stlExporter);
+    ofVec3f modelScale = getModelScale();
+    
+    if( voxelResolution < 1 )
+        voxelResolution = 1;
+    
+    voxelGrid voxels;
+    voxels.clear((float)DEFAULT_CUBE_SIZE / voxelResolution);
+    
+    ofVec3f center;
+    for( unsigned long i = visibleStart; i < visibleEnd; i++ ) {
+        data.getLoc(i, center);
+        center += getSetOffset(clusters.find(i));
+        center *= modelScale;
+        voxels.addCube(center, DEFAULT_CUBE_SIZE);
     }
     
-    stlExporter.useASCIIFormat(false); //export as binary
-    stlExporter.saveModel(ofToDataPath("outputs/dataCrystal.stl"));
+    indexedMesh mesh;
+    voxels.buildSurface(mesh);
+    
+    if( saveMeshFile(ofToDataPath(path), "dataCrystal", mesh) )
+        cout << path << ": " << voxels.getNumVoxels() << " voxels, " << mesh.getNumTriangles() << " triangles\n";
+}
+
+//-- save as, the format comes from the extension that's typed, exportFormat if there isn't one
+void dataCrystalsApp::saveMeshAs( bool bMerged ) {
+    string defaultName = (bMerged ? "dataCrystalMerged." : "dataCrystal.") + exportFormat;
+    ofFileDialogResult result = ofSystemSaveDialog(defaultName, "Save crystal as .stl, .ply or .obj");
+    
+    if( result.bSuccess == false )
+        return;
+    
+    string path = result.getPath();
+    if( isMeshFileFormat(ofFilePath::getFileExt(path)) == false )
+        path += "." + exportFormat;
+    
+    if( bMerged )
+        saveMergedMesh(path);
+    else
+        saveMesh(path);
 }
 
 float dataCrystalsApp::map(float m, float in_min, float in_max, float out_min, float out_max) {
@@ -945,13 +1627,18 @@ void dataCrystalsApp::dragEvent(ofDragInfo dragInfo){
 
 }
 
-void dataCrystalsApp::initGui() {
+//-- slider defaults, also used in batch mode where there is no GUI
+void dataCrystalsApp::initSettings() {
     xScale = 1.0f;
     yScale = 1.0f;
     zScale = 1.0f;
     gravRatio = .9f;
     jigglePct = .5f;
     clusterPct = .8;
+}
+
+void dataCrystalsApp::initGui() {
+    initSettings();
     
     gui.setup(); // most of the time you don't need a name
     
@@ -960,12 +1647,12 @@ void dataCrystalsApp::initGui() {
     gui.add(gravSlider.setup( "gravity", gravRatio, .001, 1.5 ));
     gui.add(jiggleSlider.setup("jiggle", jigglePct,.1,3.0));
    
-    //-- SCALING NOT ACTUALLY WORKING
+    //-- scale is a transform on the loaded data, see getModelScale()
     gui.add(xScaleSlider.setup( "xy scale", xScale, .25, 4 ));
 //    gui.add(yScaleSlider.setup( "y scale", yScale, .25, 4 ));
     gui.add(zScaleSlider.setup( "z scale", zScale, .25, 4 ));
     gui.add(clusterPctSlider.setup( "cluster %", clusterPct, .1, .9 ));
-
+    
     //    //gui.add(applyButton.setup("apply scale" ));
     
     // listeners
@@ -991,14 +1678,9 @@ void dataCrystalsApp::jiggleSliderChanged(float & val){
 }
 
 
+//-- the scale sliders only change the transform, the next frame and the next cycle pick it up
 void dataCrystalsApp::xScaleChanged(float & val){
     xScale = val;
-    
-    // 3nd pass: make adjustments averages for x, y and z
-//    for( unsigned long i = 0; i < numData; i++ ) {
-//        (data+i)->scaleValues( xScale, yScale, zScale );
-//    }
-
 }
 
 
@@ -1010,6 +1692,11 @@ void dataCrystalsApp::zScaleChanged(float & val){
     zScale = val;
 }
 
+//-- the "xy scale" slider scales both x and y, there is no separate y slider
+ofVec3f dataCrystalsApp::getModelScale() {
+    return ofVec3f(xScale, xScale, zScale);
+}
+
 void dataCrystalsApp::clusterPctChanged(float & val){
     clusterPct = val;
 }
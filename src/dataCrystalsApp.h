@@ -11,10 +11,57 @@
 
 #include "ofMain.h"
 #include "ofxGui.h"
-#include "datum.h"
+#include "datumStore.h"
+#include "spatialGrid.h"
+#include "clusterSet.h"
+#include "threadPool.h"
+#include "cubeRenderer.h"
+#include "labelRenderer.h"
+#include "csvColumnReader.h"
+#include "voxelGrid.h"
 
 #define DEFAULT_SCREEN_WIDTH (1280)
 #define DEFAULT_SCREEN_HEIGHT (800)
+#define NUM_PALETTE_COLORS (DATUM_COLOR_WHITE + 1)
+
+
+//-- one entry per loaded CSV, where its rows are in data
+struct datasetFile {
+    datasetFile( string _filename, unsigned long _offset, unsigned long _numRows ) :
+        filename(_filename), offset(_offset), numRows(_numRows) {}
+    
+    string filename;
+    unsigned long offset;
+    unsigned long numRows;
+};
+
+
+//-- everything draw() needs from the simulation, see publishSnapshot()
+struct crystalSnapshot {
+    //-- visible data only, cluster by cluster
+    vector<ofVec3f> positions;
+    vector<float> sizes;
+    vector<ofColor> colors;
+    vector<cubeGroup> groups;
+    
+    //-- top-level data, only filled in when drawing cluster IDs
+    vector<ofVec3f> labelPositions;
+    vector<unsigned long> labels;
+    
+    //-- bumped on every publish, so draw() knows when to re-upload the cubes
+    unsigned long version = 0;
+    
+    unsigned long numClusterCycles = 0;
+    unsigned long numUnattached = 0;
+    unsigned long numParents = 0;
+    unsigned long numChildren = 0;
+    int maxUnattachedSize = 0;
+    unsigned long numVisible = 0;
+    unsigned long numData = 0;
+    
+    //-- 0 unless a load is in progress, numVisible is how far along it is
+    unsigned long numToLoad = 0;
+};
 
 
 class dataCrystalsApp : public ofBaseApp{
@@ -23,7 +70,8 @@ class dataCrystalsApp : public ofBaseApp{
 		void setup();
 		void update();
 		void draw();
-
+		void exit();
+		
 		void keyPressed(int key);
 		void keyReleased(int key);
 		void mouseMoved(int x, int y );
@@ -33,15 +81,26 @@ class dataCrystalsApp : public ofBaseApp{
 		void windowResized(int w, int h);
 		void dragEvent(ofDragInfo dragInfo);
 		void gotMessage(ofMessage msg);
-
+    
+        //-- headless batch mode, see batchMain.cpp
+        void setupBatch();
+        void loadBatchData( string filename, int category );     // empty filename = all CSVs
+        unsigned long clusterToConvergence( unsigned long maxCycles );
+        bool isClusterDone() { return numVisible < 2 || (numUnattached == 0 && numParents == 1); }
+        //-- the format comes from the extension, .stl, .ply or .obj, an empty path is outputs/ in exportFormat
+        void saveMesh( string path = "" );
+        void saveMergedMesh( string path = "", int voxelResolution = VOXEL_DEFAULT_RESOLUTION );
+        void saveMeshAs( bool bMerged );
+        string exportFormat;
+        vector <ofFile> &getCSVFiles() { return csvFiles; }
+        
         // camera
         ofEasyCam cam;
     
-        // data points
-        datum *data;
+        // data points, one array per field, re-used between loads
+        datumStore data;
         unsigned long numData = 0;
         unsigned long numVisible;
-        unsigned short nextClusterID;
         int maxUnattachedSize;
         bool bDrawClusterIDs;
         bool bUseColor;
@@ -56,26 +115,109 @@ class dataCrystalsApp : public ofBaseApp{
         //-- VARIABLES
         unsigned long numClusterCycles;
     
-        void loadCSVFiles();
+        void initVars();
+    
+        void listCSVFiles();
         void loadAllData();
-        unsigned long loadCSVData(string filename, datum *dataPtr, int fileIndex);
-        void saveMesh();
+        void parseAllFiles( vector<csvColumns> &parsedFiles );
+        void fillAllData( vector<csvColumns> &parsedFiles );
+        unsigned long loadCSVData(string filename);
+        bool readInputFile(string filename, csvColumns &csv);
+        unsigned long fillCSVData(csvColumns &csv, unsigned long dataOffset, ofVec3f &average);
+        void getCSVAverage(csvColumns &csv, ofVec3f &average);
+        unsigned long fillCSVRows(csvColumns &csv, unsigned long dataOffset, unsigned long start, unsigned long end, const ofVec3f &average);
+        void sortColumnsByCategory(csvColumns &csv);
+        void setVisibleRange();
+        void setLoadedColumns(string filename, csvColumns &csv);
+        void beginCategory(ofVec3f &average);
+        
+        //-- a single file is stored sorted by category, [first, second) of data for each category
+        std::map<int, pair<unsigned long, unsigned long> > categoryRanges;
+        csvColumns loadedColumns;
+        string loadedColumnsFile;
+        
+        //-- the only data the simulation and drawing look at, all of it when everything is shown
+        unsigned long visibleStart;
+        unsigned long visibleEnd;
+    
+        //-- built on every load, so recoloring never goes back to disk
+        vector<datasetFile> manifest;
+    
+        //-- SIMULATION THREAD
+        void startSimulation();
+        void stopSimulation();
+        void simulationLoop();
+        void publishSnapshot( bool bForce );
+    
+        std::thread simulationThread;
+        std::atomic<bool> bSimulationRunning;
+    
+        //-- loads run on the simulation thread too, see requestLoad()
+        void requestLoad( int request );
+        void runLoad( int request );
+        std::atomic<int> pendingLoad;
+        std::atomic<bool> bLoading;
+        unsigned long loadEnd;
+    
+        //-- held by the simulation thread for each step, and by the UI thread whenever it changes the data
+        std::mutex simMutex;
+    
+        //-- double-buffered, draw() holds snapshotMutex and reads snapshots[frontSnapshot]
+        std::mutex snapshotMutex;
+        crystalSnapshot snapshots[2];
+        int frontSnapshot;
+        uint64_t lastSnapshotTime;
+        unsigned long snapshotVersion;
     
-        void makeClusters();
-        void bindClusters( datum *d1, datum *d2);
-        void attachToCluster(datum *subCluster, datum *mainCluster);
+        //-- every visible cube in one instanced draw call
+        cubeRenderer cubes;
+        labelRenderer labels;      // cluster IDs, when bDrawClusterIDs
+        unsigned long drawnSnapshotVersion;
+    
+        void clusterCycle();
+        void makeClusters( const ofVec3f &modelScale );
+        void bindClusters( unsigned long d1, unsigned long d2);
+        void attachToCluster(unsigned long subCluster, unsigned long mainCluster);
     
         void findGravCenter();
-        bool inClusterDistance( datum *d1, datum *d2 );
         void countParentsAndChildren();
-        bool inSameCluster( datum *d1, datum *d2 );
+        void resetClusters();
+    
+        //-- running sum of the clustered world positions, for findGravCenter()
+        void addToGravSum( const ofVec3f &loc, unsigned long count );
+        void resyncGravSum();
+        double gravSumX, gravSumY, gravSumZ;
+        bool inSameCluster( unsigned long d1, unsigned long d2 );
+        bool isUnattached( unsigned long i );
+        bool isChild( unsigned long i );
+        bool isTopLevel( unsigned long i );
+    
+        //-- cluster membership by datum id, reset on every load
+        clusterSet clusters;
+    
+        //-- by clusterSet::getSetIndex(), moving a cluster only moves this, world = datum (x, y, z) + offset,
+        //-- unattached data have none, they move themselves
+        vector<ofVec3f> setOffsets;
+        const ofVec3f &getSetOffset( unsigned long root );
+        void getWorldLoc( unsigned long i, ofVec3f &loc );
+    
+        //-- broadphase for makeClusters(), rebuilt every cycle
+        spatialGrid clusterGrid;
+    
+        //-- parallel pair detection for makeClusters()
+        void findBindPairs( unsigned long chunk, int threadIndex, float minClusterDistSq );
+        threadPool clusterThreads;
+        vector< vector< pair<unsigned long, unsigned long> > > bindPairs;
+        vector< vector< pair<unsigned long, unsigned long> > > threadRanges;
+        vector< vector<unsigned long> > threadHits;
     
         // CSV files
         vector <ofFile> csvFiles;
         int numCSVFiles;
         int currentFileIndex;
     
-        Boolean bClustering;
+        //-- set from the UI thread, read by the simulation thread
+        std::atomic<bool> bClustering;
         unsigned long numChildren;
         unsigned long numParents;
         unsigned long numUnattached;
@@ -88,36 +230,42 @@ class dataCrystalsApp : public ofBaseApp{
         string numDataPointsStr;
     
         // GUI
+        void initSettings();
         void initGui();
         
         bool bHideGui;
         bool bShowClusterStatus;
         ofxPanel gui;
     
+        //-- the slider values are set on the UI thread and read by the simulation thread
         ofxFloatSlider gravSlider;
-        float gravRatio;
+        std::atomic<float> gravRatio;
         void gravSliderChanged(float & val);
     
         ofxFloatSlider jiggleSlider;
-        float jigglePct;
+        std::atomic<float> jigglePct;
         void jiggleSliderChanged(float & val);
     
         ofxFloatSlider xScaleSlider;
-        float xScale;
+        std::atomic<float> xScale;
         void xScaleChanged(float & val);
     
     
         ofxFloatSlider yScaleSlider;
-        float yScale;
+        std::atomic<float> yScale;
         void yScaleChanged(float & val);
     
     
         ofxFloatSlider zScaleSlider;
-        float zScale;
+        std::atomic<float> zScale;
         void zScaleChanged(float & val);
     
+        //-- model transform from the sliders: drawing, clustering distance and export, never the data
+        //-- the simulation thread reads it once at the start of each cycle
+        ofVec3f getModelScale();
+    
         ofxFloatSlider clusterPctSlider;
-        float clusterPct;
+        std::atomic<float> clusterPct;
         void clusterPctChanged(float & val);
     
     
@@ -130,6 +278,9 @@ class dataCrystalsApp : public ofBaseApp{
         void getColorFromFileIndex(int currentFileIndex, unsigned short &r, unsigned short &b, unsigned short &g);
         void applyColor();
         void applyColorToAll();
+        int getColorIndex(int fileIndex);
+        void initColorPalette();
+        ofColor colorPalette[NUM_PALETTE_COLORS];
         std::string makePointsStr(unsigned long value);
     
         void drawClusterStatus();
@@ -142,9 +293,10 @@ class dataCrystalsApp : public ofBaseApp{
         char numChildrenString[64];
         char numDataString[64];
         char numVisibleString[64];
-        char clusterString[64];
         char maxUnattachedSizeString[64];
+        char numDrawnString[64];
         char sizeOnString[64];
         char fileDisplayStr[64];
         char treeDisplayStr[64];
+        char exportFormatString[64];
 };
@@ -0,0 +1,191 @@
+/*********************************************************
+ datasetCache.cpp
+ Binary cache of parsed CSV columns implementation for Data Crystals
+ 
+ File layout, all native-endian:
+    header, source path bytes, then numRows of each kept column:
+    int32 categories, float xs, float ys, float sizes
+ 
+ **********************************************************/
+
+#include "datasetCache.h"
+#include "mappedFile.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <fstream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+#define DATASET_CACHE_VERSION (2)
+
+
+struct datasetCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    int64_t sourceTimeNsec;
+    uint64_t numRows;
+    int32_t categoryColumn;
+    int32_t xColumn;
+    int32_t yColumn;
+    int32_t sizeColumn;
+    uint32_t pathLength;
+};
+
+static const char datasetCacheMagic[4] = { 'D', 'C', 'R', 'Y' };
+
+
+//-- size and modification time of the source, false if it doesn't exist
+//-- the nanoseconds matter, a file rewritten within the same second has the same st_mtime
+static bool getSourceStamp( const std::string &path, uint64_t &size, int64_t &time, int64_t &timeNsec ) {
+#ifdef _WIN32
+    //-- last write time is in 100 ns ticks
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if( GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info) == 0 )
+        return false;
+    
+    size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    uint64_t ticks = ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+    time = (int64_t)(ticks / 10000000);
+    timeNsec = (int64_t)(ticks % 10000000) * 100;
+    return true;
+#else
+    struct stat st;
+    if( stat(path.c_str(), &st) != 0 )
+        return false;
+    
+    size = (uint64_t)st.st_size;
+    time = (int64_t)st.st_mtime;
+#ifdef __APPLE__
+    timeNsec = (int64_t)st.st_mtimespec.tv_nsec;
+#else
+    timeNsec = (int64_t)st.st_mtim.tv_nsec;
+#endif
+    return true;
+#endif
+}
+
+//-- copies one column out of the mapped file, advancing p
+template <typename T>
+static bool readColumn( const char *&p, const char *end, unsigned long numRows, std::vector<T> &column ) {
+    unsigned long numBytes = numRows * sizeof(T);
+    if( (unsigned long)(end - p) < numBytes )
+        return false;
+    
+    column.resize(numRows);
+    if( numBytes > 0 )
+        memcpy(&column[0], p, numBytes);
+    
+    p += numBytes;
+    return true;
+}
+
+template <typename T>
+static void writeColumn( std::ofstream &out, const std::vector<T> &column ) {
+    if( column.empty() == false )
+        out.write((const char *)&column[0], column.size() * sizeof(T));
+}
+
+bool readDatasetCache( const std::string &cachePath, const std::string &sourcePath, csvColumns &columns ) {
+    uint64_t sourceSize;
+    int64_t sourceTime, sourceTimeNsec;
+    if( getSourceStamp(sourcePath, sourceSize, sourceTime, sourceTimeNsec) == false )
+        return false;
+    
+    mappedFile file;
+    if( file.open(cachePath) == false )
+        return false;
+    
+    const char *p = file.getData();
+    const char *end = p + file.getSize();
+    
+    datasetCacheHeader header;
+    if( file.getSize() < sizeof(header) )
+        return false;
+    
+    memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+    
+    //-- anything that doesn't match means the source or the request changed
+    if( memcmp(header.magic, datasetCacheMagic, sizeof(header.magic)) != 0 ||
+        header.version != DATASET_CACHE_VERSION ||
+        header.sourceSize != sourceSize ||
+        header.sourceTime != sourceTime ||
+        header.sourceTimeNsec != sourceTimeNsec ||
+        header.categoryColumn != columns.categoryColumn ||
+        header.xColumn != columns.xColumn ||
+        header.yColumn != columns.yColumn ||
+        header.sizeColumn != columns.sizeColumn ||
+        header.pathLength != sourcePath.size() ||
+        (unsigned long)(end - p) < header.pathLength ||
+        sourcePath.compare(0, std::string::npos, p, header.pathLength) != 0 )
+        return false;
+    
+    p += header.pathLength;
+    
+    unsigned long numRows = (unsigned long)header.numRows;
+    
+    if( columns.categoryColumn != CSV_SKIP_COLUMN && readColumn(p, end, numRows, columns.categories) == false )
+        return false;
+    if( columns.xColumn != CSV_SKIP_COLUMN && readColumn(p, end, numRows, columns.xs) == false )
+        return false;
+    if( columns.yColumn != CSV_SKIP_COLUMN && readColumn(p, end, numRows, columns.ys) == false )
+        return false;
+    if( columns.sizeColumn != CSV_SKIP_COLUMN && readColumn(p, end, numRows, columns.sizes) == false )
+        return false;
+    
+    columns.numRows = numRows;
+    return true;
+}
+
+bool writeDatasetCache( const std::string &cachePath, const std::string &sourcePath, const csvColumns &columns ) {
+    //-- zeroed, so the padding is too and the same CSV always gives the same cache bytes
+    datasetCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, datasetCacheMagic, sizeof(header.magic));
+    header.version = DATASET_CACHE_VERSION;
+    if( getSourceStamp(sourcePath, header.sourceSize, header.sourceTime, header.sourceTimeNsec) == false )
+        return false;
+    
+    header.numRows = columns.numRows;
+    header.categoryColumn = columns.categoryColumn;
+    header.xColumn = columns.xColumn;
+    header.yColumn = columns.yColumn;
+    header.sizeColumn = columns.sizeColumn;
+    header.pathLength = (uint32_t)sourcePath.size();
+    
+    //-- write beside the real file and rename, so a reboot mid-write never leaves a half cache
+    std::string tempPath = cachePath + ".tmp";
+    
+    {
+        std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+        if( !out )
+            return false;
+        
+        out.write((const char *)&header, sizeof(header));
+        out.write(sourcePath.data(), sourcePath.size());
+        
+        if( columns.categoryColumn != CSV_SKIP_COLUMN )
+            writeColumn(out, columns.categories);
+        if( columns.xColumn != CSV_SKIP_COLUMN )
+            writeColumn(out, columns.xs);
+        if( columns.yColumn != CSV_SKIP_COLUMN )
+            writeColumn(out, columns.ys);
+        if( columns.sizeColumn != CSV_SKIP_COLUMN )
+            writeColumn(out, columns.sizes);
+        
+        if( !out )
+            return false;
+    }
+    
+    //-- Windows rename() won't replace an existing file
+    remove(cachePath.c_str());
+    return rename(tempPath.c_str(), cachePath.c_str()) == 0;
+}
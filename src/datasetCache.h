@@ -0,0 +1,32 @@
+/*********************************************************
+    datasetCache.h
+    Binary cache of parsed CSV columns for Data Crystals
+ 
+    Notes:
+    - one cache file per input CSV, holding the parsed category, x, y
+        and (optional) size columns as raw arrays
+ 
+    - keyed by the source path, size and modification time (to the
+        nanosecond, where the file system has it), plus the
+        columns that were asked for; any mismatch means stale and the
+        caller falls back to the text parser
+ 
+    - the cache file is memory-mapped on load, so reading it is a
+        header check and one copy per column
+**********************************************************/
+
+
+#ifndef __datasetCache__
+#define __datasetCache__
+
+#include <string>
+#include "csvColumnReader.h"
+
+
+//-- fills columns (whose column numbers are already set) from the cache, false if missing or stale
+bool readDatasetCache( const std::string &cachePath, const std::string &sourcePath, csvColumns &columns );
+
+//-- writes the parsed columns for sourcePath, false if the cache file can't be written
+bool writeDatasetCache( const std::string &cachePath, const std::string &sourcePath, const csvColumns &columns );
+
+#endif /* defined(__datasetCache__) */
@@ -0,0 +1,82 @@
+/*********************************************************
+ datumStore.cpp
+ Structure-of-arrays data storage implementation for Data Crystals
+ 
+ **********************************************************/
+
+#include "datumStore.h"
+
+
+datumStore::datumStore() {
+}
+
+void datumStore::reset( unsigned long n ) {
+    xs.assign(n, 0);
+    ys.assign(n, 0);
+    zs.assign(n, 0);
+    categories.assign(n, 0);
+    colorIndices.assign(n, DATUM_COLOR_WHITE);
+    
+    clusterIDs.resize(n);
+    for( unsigned long i = 0; i < n; i++ )
+        clusterIDs[i] = (uint32_t)i;
+}
+
+void datumStore::set( unsigned long i, float x, float y, float z, int category ) {
+    xs[i] = x;
+    ys[i] = y;
+    zs[i] = z;
+    categories[i] = (uint8_t)category;
+    clusterIDs[i] = (uint32_t)i;
+}
+
+void datumStore::adjust( unsigned long i, float xAdjust, float yAdjust, float zAdjust ) {
+    xs[i] += xAdjust;
+    ys[i] += yAdjust;
+    zs[i] += zAdjust;
+}
+
+//-- moves the whole cluster at once, offset belongs to the cluster of i (or just i, when unattached)
+void datumStore::jiggle( unsigned long i, float jigglePct, int maxJiggleSize, ofVec3f &gravCenter, float gravRatio,
+                         const ofVec3f &modelScale, ofVec3f &offset ) {
+    //-- world position of i
+    float wx = xs[i] + offset.x;
+    float wy = ys[i] + offset.y;
+    float wz = zs[i] + offset.z;
+    
+    int jigglesSize = (maxJiggleSize < DEFAULT_CUBE_SIZE) ? maxJiggleSize : DEFAULT_CUBE_SIZE;
+    float jiggleAmount = jigglesSize * jigglePct;
+
+    float rxMin = -jiggleAmount;
+    float rxMax = jiggleAmount;
+
+    if( gravCenter.x + wx > 0 )
+        rxMax = rxMax * gravRatio;
+    else if( gravCenter.x + wx  < 0 )
+        rxMin = rxMin * gravRatio;
+    
+    float ryMin = -jiggleAmount;
+    float ryMax = jiggleAmount;
+    
+    if( gravCenter.y + wy > 0 )
+        ryMax = ryMax * gravRatio;
+    else if( gravCenter.y + wy < 0 )
+        ryMin = ryMin * gravRatio;
+    
+    float rzMin = -jiggleAmount;
+    float rzMax = jiggleAmount;
+    
+    if( gravCenter.z  + wz > 0 )
+        rzMax = rzMax * gravRatio;
+    else if( gravCenter.z + wz < 0 )
+        rzMin = rzMin * gravRatio;
+    
+    float mx = ofRandom(rxMin, rxMax);
+    float my = ofRandom(ryMin, ryMax);
+    float mz = ofRandom(rzMin, rzMax);
+    
+    //-- binding is tested on scaled positions, keep the step the same there on every axis
+    offset.x += mx / modelScale.x;
+    offset.y += my / modelScale.y;
+    offset.z += mz / modelScale.z;
+}
@@ -0,0 +1,75 @@
+/*********************************************************
+    datumStore.h
+    Structure-of-arrays data storage for Data Crystals
+ 
+    Notes:
+    - replaces the datum class: one contiguous array per field
+        instead of one object per point, so the clustering loops
+        only pull in the fields they use
+ 
+    - 18 bytes per datum: x, y, z floats, 8-bit category, 8-bit
+        color index and a 32-bit cluster ID
+ 
+    - every cube is DEFAULT_CUBE_SIZE, the size column isn't stored
+ 
+    - parent/child status comes from dataCrystalsApp's clusterSet,
+        which already knows each cluster's size and top-level datum
+ 
+    - arrays keep their capacity between loads, so reset() only
+        allocates when a load is bigger than any before it
+**********************************************************/
+
+
+#ifndef __datumStore__
+#define __datumStore__
+
+#include "ofMain.h"
+#include <stdint.h>
+
+#define DEFAULT_CUBE_SIZE (10)      // edge of cube, in mm
+#define DATUM_COLOR_WHITE (255)     // color index past the end of getColorFromFileIndex()'s colors
+
+
+class datumStore  {
+
+public:
+    datumStore();
+    
+    //-- n data at the origin, category 0, white, every one in its own cluster
+    void reset( unsigned long n );
+    unsigned long getNumData() { return xs.size(); }
+    
+    //-- (x, y, z) are relative to the cluster offset, see dataCrystalsApp::getWorldLoc()
+    void set( unsigned long i, float x, float y, float z, int category );
+    float getX( unsigned long i ) { return xs[i]; }
+    float getY( unsigned long i ) { return ys[i]; }
+    float getZ( unsigned long i ) { return zs[i]; }
+    void getLoc( unsigned long i, ofVec3f &loc ) { loc.x = xs[i]; loc.y = ys[i]; loc.z = zs[i]; }
+    void adjust( unsigned long i, float xAdjust, float yAdjust, float zAdjust );
+    
+    int getCategory( unsigned long i ) { return categories[i]; }
+    
+    //-- index into dataCrystalsApp's color palette, see getColorFromFileIndex()
+    void setColorIndex( unsigned long i, int colorIndex ) { colorIndices[i] = (uint8_t)colorIndex; }
+    int getColorIndex( unsigned long i ) { return colorIndices[i]; }
+    
+    //-- cluster (clusterSet root) as of the start of the current cycle
+    void setClusterID( unsigned long i, unsigned long clusterID ) { clusterIDs[i] = (uint32_t)clusterID; }
+    unsigned long getClusterID( unsigned long i ) { return clusterIDs[i]; }
+    
+    //-- moves a cluster offset a random amount, i is the datum it is moved by (top-level or unattached)
+    //-- the step is divided by modelScale, so it is the same size on every axis of the crystal as drawn
+    void jiggle( unsigned long i, float jigglePct, int maxJiggleSize, ofVec3f &gravCenter, float gravRatio,
+                 const ofVec3f &modelScale, ofVec3f &offset );
+    
+private:
+    vector<float> xs;
+    vector<float> ys;
+    vector<float> zs;
+    
+    vector<uint8_t> categories;
+    vector<uint8_t> colorIndices;
+    vector<uint32_t> clusterIDs;
+};
+
+#endif /* defined(__datumStore__) */
@@ -0,0 +1,116 @@
+/*********************************************************
+ distanceKernel.cpp
+ Batched squared-distance test implementation for Data Crystals
+ 
+ The AVX2 loop is built with a target attribute rather than a global
+ -march flag, so the same binary runs on any x86_64, the SSE2 loop then
+ does the tail, or the whole thing on CPUs without AVX2
+ 
+ **********************************************************/
+
+#include "distanceKernel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #include <immintrin.h>
+    #define DISTANCE_KERNEL_AVX2
+#endif
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+
+#ifdef DISTANCE_KERNEL_AVX2
+//-- asked once, the first time through
+static bool hasAVX2() {
+    static const bool bAVX2 = __builtin_cpu_supports("avx2");
+    return bAVX2;
+}
+#endif
+
+const char *getDistanceKernelName() {
+#ifdef DISTANCE_KERNEL_AVX2
+    if( hasAVX2() )
+        return "AVX2";
+#endif
+#if defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+//-- walks the set bits of a lane mask, lowest lane first
+static inline void addHits( int mask, unsigned long base, std::vector<unsigned long> &hits ) {
+    for( int lane = 0; mask != 0; lane++, mask >>= 1 ) {
+        if( mask & 1 )
+            hits.push_back(base + lane);
+    }
+}
+
+#ifdef DISTANCE_KERNEL_AVX2
+//-- whole blocks of 8, returns how many candidates it did, only call when hasAVX2()
+__attribute__((target("avx2")))
+static unsigned long findWithinDistanceAVX2( float x, float y, float z,
+                                             const float *xs, const float *ys, const float *zs, unsigned long numCandidates,
+                                             float maxDistSq, std::vector<unsigned long> &hits ) {
+    unsigned long i = 0;
+    
+    __m256 px = _mm256_set1_ps(x);
+    __m256 py = _mm256_set1_ps(y);
+    __m256 pz = _mm256_set1_ps(z);
+    __m256 maxD = _mm256_set1_ps(maxDistSq);
+    
+    for( ; i + 8 <= numCandidates; i += 8 ) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs+i), px);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys+i), py);
+        __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(zs+i), pz);
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(d, maxD, _CMP_LT_OQ));
+        if( mask )
+            addHits(mask, i, hits);
+    }
+    
+    return i;
+}
+#endif
+
+void findWithinDistance( float x, float y, float z,
+                         const float *xs, const float *ys, const float *zs, unsigned long numCandidates,
+                         float maxDistSq, std::vector<unsigned long> &hits ) {
+    unsigned long i = 0;
+    
+#ifdef DISTANCE_KERNEL_AVX2
+    if( hasAVX2() )
+        i = findWithinDistanceAVX2(x, y, z, xs, ys, zs, numCandidates, maxDistSq, hits);
+#endif
+    
+#if defined(__SSE2__)
+    __m128 px = _mm_set1_ps(x);
+    __m128 py = _mm_set1_ps(y);
+    __m128 pz = _mm_set1_ps(z);
+    __m128 maxD = _mm_set1_ps(maxDistSq);
+    
+    for( ; i + 4 <= numCandidates; i += 4 ) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs+i), px);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys+i), py);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(zs+i), pz);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(d, maxD));
+        if( mask )
+            addHits(mask, i, hits);
+    }
+#endif
+    
+    //-- scalar tail, or the whole thing without SIMD
+    for( ; i < numCandidates; i++ ) {
+        float dx = xs[i] - x;
+        float dy = ys[i] - y;
+        float dz = zs[i] - z;
+        
+        if( dx*dx + dy*dy + dz*dz < maxDistSq )
+            hits.push_back(i);
+    }
+}
@@ -0,0 +1,30 @@
+/*********************************************************
+    distanceKernel.h
+    Batched squared-distance test for Data Crystals
+ 
+    Notes:
+    - compares one point against a block of candidates stored as
+        contiguous x, y and z arrays (see spatialGrid), squared
+        distance only, so no sqrt per pair
+ 
+    - 8 lanes with AVX2, 4 lanes with SSE2, scalar otherwise; only the
+        AVX2 function is compiled for AVX2, and it is picked at run time
+        when the CPU has it, so the build needs no -march flags
+**********************************************************/
+
+
+#ifndef __distanceKernel__
+#define __distanceKernel__
+
+#include <vector>
+
+//-- appends to hits the offset (into xs/ys/zs) of every candidate closer than sqrt(maxDistSq) to (x,y,z),
+//-- in ascending order
+void findWithinDistance( float x, float y, float z,
+                         const float *xs, const float *ys, const float *zs, unsigned long numCandidates,
+                         float maxDistSq, std::vector<unsigned long> &hits );
+
+//-- name of the path this CPU takes, for the console
+const char *getDistanceKernelName();
+
+#endif /* defined(__distanceKernel__) */
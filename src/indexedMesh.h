@@ -0,0 +1,40 @@
+/*********************************************************
+    indexedMesh.h
+    Triangle mesh with shared vertices for Data Crystals
+    
+    Notes:
+    - what the merged and PLY/OBJ exports build before writing, the
+        plain cube STL export in stlWriter doesn't need one
+    
+    - 3 indices per triangle, counter-clockwise seen from outside
+**********************************************************/
+
+
+#ifndef __indexedMesh__
+#define __indexedMesh__
+
+#include "ofMain.h"
+#include <stdint.h>
+
+
+struct indexedMesh {
+    vector<ofVec3f> vertices;
+    vector<uint32_t> indices;
+    
+    void clear() { vertices.clear(); indices.clear(); }
+    
+    unsigned long getNumTriangles() const { return indices.size() / 3; }
+    
+    uint32_t addVertex( const ofVec3f &v ) {
+        vertices.push_back(v);
+        return (uint32_t)(vertices.size() - 1);
+    }
+    
+    void addTriangle( uint32_t a, uint32_t b, uint32_t c ) {
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+};
+
+#endif /* defined(__indexedMesh__) */
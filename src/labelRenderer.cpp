@@ -0,0 +1,106 @@
+/*********************************************************
+ labelRenderer.cpp
+ Batched cluster ID labels implementation for Data Crystals
+ 
+ Projection is worldToClip() from clipSpace.h, as in cubeRenderer.cpp,
+ then the usual OF screen, y down
+ 
+ **********************************************************/
+
+#include "labelRenderer.h"
+#include "clipSpace.h"
+
+
+labelRenderer::labelRenderer() {
+    modelScale = ofVec3f(1, 1, 1);
+    numDrawn = 0;
+    bDirty = true;
+}
+
+void labelRenderer::update( const vector<ofVec3f> &_positions, const vector<unsigned long> &_labels ) {
+    positions = _positions;
+    labels = _labels;
+    bDirty = true;
+}
+
+const string &labelRenderer::getLabelString( unsigned long label ) {
+    if( label >= labelStrings.size() )
+        labelStrings.resize(label + 1);
+    
+    if( labelStrings[label].empty() )
+        labelStrings[label] = ofToString(label);
+    
+    return labelStrings[label];
+}
+
+void labelRenderer::buildMesh( const ofMatrix4x4 &mvp, const ofRectangle &viewport ) {
+    textMesh.clear();
+    numDrawn = 0;
+    
+    int cellsX = (int)(viewport.width / LABEL_CELL_WIDTH) + 1;
+    int cellsY = (int)(viewport.height / LABEL_CELL_HEIGHT) + 1;
+    cellTaken.assign(cellsX * cellsY, 0);
+    
+    for( unsigned long i = 0; i < positions.size(); i++ ) {
+        float x = positions[i].x * modelScale.x + LABEL_OFFSET;
+        float y = positions[i].y * modelScale.y + LABEL_OFFSET;
+        float z = positions[i].z * modelScale.z + LABEL_OFFSET;
+        
+        //-- behind the camera
+        ofVec4f clip = worldToClip(mvp, x, y, z);
+        if( clip.w <= 0 )
+            continue;
+        
+        float ndcX = clip.x / clip.w;
+        float ndcY = clip.y / clip.w;
+        
+        float screenX = (ndcX + 1.0f) * 0.5f * viewport.width;
+        float screenY = (1.0f - ndcY) * 0.5f * viewport.height;
+        
+        //-- off screen
+        if( screenX < 0 || screenY < 0 || screenX >= viewport.width || screenY >= viewport.height )
+            continue;
+        
+        //-- on top of one we already have
+        int cell = (int)(screenY / LABEL_CELL_HEIGHT) * cellsX + (int)(screenX / LABEL_CELL_WIDTH);
+        if( cellTaken[cell] )
+            continue;
+        
+        cellTaken[cell] = 1;
+        
+        const ofMesh &glyphs = font.getMesh(getLabelString(labels[i]), (int)(viewport.x + screenX), (int)(viewport.y + screenY));
+        textMesh.addVertices(glyphs.getVertices());
+        textMesh.addTexCoords(glyphs.getTexCoords());
+        numDrawn++;
+    }
+}
+
+void labelRenderer::draw( ofCamera &cam ) {
+    if( positions.size() == 0 )
+        return;
+    
+    ofRectangle viewport = ofGetCurrentViewport();
+    ofMatrix4x4 mvp = cam.getModelViewProjectionMatrix(viewport);
+    
+    if( bDirty || isSameMatrix(mvp, lastMVP) == false ||
+        modelScale.x != lastScale.x || modelScale.y != lastScale.y || modelScale.z != lastScale.z ||
+        viewport.width != lastViewport.width || viewport.height != lastViewport.height ) {
+        buildMesh(mvp, viewport);
+        
+        lastMVP = mvp;
+        lastScale = modelScale;
+        lastViewport = viewport;
+        bDirty = false;
+    }
+    
+    if( numDrawn == 0 )
+        return;
+    
+    //-- one call for every label, the font texture is alpha only
+    ofPushStyle();
+    ofEnableAlphaBlending();
+    font.getTexture().bind();
+    textMesh.draw();
+    font.getTexture().unbind();
+    ofPopStyle();
+}
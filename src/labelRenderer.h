@@ -0,0 +1,76 @@
+/*********************************************************
+    labelRenderer.h
+    Batched cluster ID labels for Data Crystals
+    
+    Notes:
+    - the string for each cluster ID is made once and kept, IDs never
+        change their text
+    
+    - labels are projected to the screen on the CPU, ones behind the
+        camera or off screen are dropped, and where labels would land on
+        top of each other only the first is kept, so thousands of them
+        stay readable
+    
+    - every label goes into one mesh of bitmap font glyphs, drawn with a
+        single call, and only rebuilt when the camera, the scale or the
+        labels change
+    
+    - draw() is in screen space, call it after cam.end()
+**********************************************************/
+
+
+#ifndef __labelRenderer__
+#define __labelRenderer__
+
+#include "ofMain.h"
+
+//-- one label per cell of this many pixels
+#define LABEL_CELL_WIDTH (40)
+#define LABEL_CELL_HEIGHT (14)
+
+//-- labels sit this far (unscaled) from their datum, as the old ofDrawBitmapString() ones did
+#define LABEL_OFFSET (20)
+
+
+class labelRenderer  {
+
+public:
+    labelRenderer();
+    
+    //-- copies the labels in, only call when they change
+    void update( const vector<ofVec3f> &positions, const vector<unsigned long> &labels );
+    
+    //-- scales the label positions, same as cubeRenderer::setModelScale()
+    void setModelScale( const ofVec3f &scale ) { modelScale = scale; }
+    
+    //-- every label that shows, as seen by cam
+    void draw( ofCamera &cam );
+    
+    unsigned long getNumDrawn() { return numDrawn; }
+
+private:
+    vector<ofVec3f> positions;
+    vector<unsigned long> labels;
+    ofVec3f modelScale;
+    
+    //-- by cluster ID, "" until first needed
+    vector<string> labelStrings;
+    
+    ofBitmapFont font;
+    ofVboMesh textMesh;
+    unsigned long numDrawn;
+    
+    //-- what the mesh was built for
+    bool bDirty;
+    ofMatrix4x4 lastMVP;
+    ofVec3f lastScale;
+    ofRectangle lastViewport;
+    
+    //-- scratch, which screen cells already have a label
+    vector<char> cellTaken;
+    
+    const string &getLabelString( unsigned long label );
+    void buildMesh( const ofMatrix4x4 &mvp, const ofRectangle &viewport );
+};
+
+#endif /* defined(__labelRenderer__) */
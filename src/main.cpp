@@ -9,10 +9,21 @@
 
 #include "ofMain.h"
 #include "dataCrystalsApp.h"
+#include "batchMain.h"
 
 //========================================================================
-int main( ){
-	ofSetupOpenGL(DEFAULT_SCREEN_WIDTH,DEFAULT_SCREEN_HEIGHT,OF_WINDOW);			// <-------- setup the GL context
+int main( int argc, char *argv[] ){
+	//-- headless: DataCrystals --batch [options], see batchMain.cpp
+	if( argc > 1 && strcmp(argv[1], "--batch") == 0 )
+		return runBatch(argc, argv);
+
+	//-- GL 3.2 programmable renderer, for the instanced cubes (see cubeRenderer.h)
+	ofGLWindowSettings settings;
+	settings.setGLVersion(3,2);
+	settings.width = DEFAULT_SCREEN_WIDTH;
+	settings.height = DEFAULT_SCREEN_HEIGHT;
+	settings.windowMode = OF_WINDOW;
+	ofCreateWindow(settings);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
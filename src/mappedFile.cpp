@@ -0,0 +1,91 @@
+/*********************************************************
+ mappedFile.cpp
+ Read-only memory-mapped file implementation for Data Crystals
+ 
+ **********************************************************/
+
+#include "mappedFile.h"
+
+#ifdef _WIN32
+    #include <fstream>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+
+mappedFile::mappedFile() {
+    data = NULL;
+    size = 0;
+    bOpen = false;
+}
+
+mappedFile::~mappedFile() {
+    close();
+}
+
+bool mappedFile::open( const std::string &path ) {
+    close();
+    
+#ifdef _WIN32
+    std::ifstream in(path.c_str(), std::ios::binary | std::ios::ate);
+    if( !in )
+        return false;
+    
+    size = (unsigned long)in.tellg();
+    buffer.resize(size);
+    in.seekg(0);
+    
+    if( size > 0 && !in.read(&buffer[0], size) )
+        return false;
+    
+    data = (size > 0) ? &buffer[0] : NULL;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if( fd < 0 )
+        return false;
+    
+    struct stat st;
+    if( fstat(fd, &st) != 0 ) {
+        ::close(fd);
+        return false;
+    }
+    
+    size = st.st_size;
+    
+    //-- can't map an empty file, but it is still a valid (empty) file
+    if( size > 0 ) {
+        void *m = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if( m == MAP_FAILED ) {
+            ::close(fd);
+            size = 0;
+            return false;
+        }
+        
+        //-- we read front to back, once
+        madvise(m, size, MADV_SEQUENTIAL);
+        data = (const char *)m;
+    }
+    
+    //-- the mapping stays valid after the descriptor is closed
+    ::close(fd);
+#endif
+    
+    bOpen = true;
+    return true;
+}
+
+void mappedFile::close() {
+#ifdef _WIN32
+    buffer.clear();
+#else
+    if( data != NULL )
+        munmap((void *)data, size);
+#endif
+    
+    data = NULL;
+    size = 0;
+    bOpen = false;
+}
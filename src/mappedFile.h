@@ -0,0 +1,44 @@
+/*********************************************************
+    mappedFile.h
+    Read-only memory-mapped file for Data Crystals
+ 
+    Notes:
+    - mmap() on macOS / Linux, so big inputs are paged in by the OS
+        instead of being copied into our own buffers
+ 
+    - Windows just reads the whole file into memory
+**********************************************************/
+
+
+#ifndef __mappedFile__
+#define __mappedFile__
+
+#include <string>
+#include <vector>
+
+
+class mappedFile  {
+
+public:
+    mappedFile();
+    ~mappedFile();
+    
+    //-- false if the file can't be opened or mapped
+    bool open( const std::string &path );
+    void close();
+    
+    const char *getData() { return data; }
+    unsigned long getSize() { return size; }
+    bool isOpen() { return bOpen; }
+    
+private:
+    const char *data;
+    unsigned long size;
+    bool bOpen;
+    
+#ifdef _WIN32
+    std::vector<char> buffer;
+#endif
+};
+
+#endif /* defined(__mappedFile__) */
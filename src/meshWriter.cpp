@@ -0,0 +1,194 @@
+/*********************************************************
+ meshWriter.cpp
+ Indexed mesh export implementation for Data Crystals
+ 
+ PLY: text header, then per vertex 3 floats, per face a uchar count
+ of 3 and 3 int indices, 13 bytes
+ 
+ OBJ: "v x y z" lines, then "f a b c" lines with 1-based indices
+ 
+ **********************************************************/
+
+#include "meshWriter.h"
+#include "cubeGeometry.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unordered_map>
+
+#define PLY_FACE_SIZE (13)
+#define MESH_CHUNK_ITEMS (65536)        // vertices or faces per fwrite()
+
+
+//-- a corner on the weld lattice
+struct weldKey {
+    int32_t x, y, z;
+    
+    bool operator==( const weldKey &k ) const { return x == k.x && y == k.y && z == k.z; }
+};
+
+struct weldKeyHash {
+    size_t operator()( const weldKey &k ) const {
+        // same primes as spatialGrid::hashCell()
+        return ((size_t)(uint32_t)k.x * 73856093UL) ^ ((size_t)(uint32_t)k.y * 19349663UL) ^ ((size_t)(uint32_t)k.z * 83492791UL);
+    }
+};
+
+void buildCubesMesh( unsigned long numCubes, const stlCubeSource &getCube, indexedMesh &mesh ) {
+    mesh.clear();
+    mesh.vertices.reserve(numCubes * CUBE_NUM_CORNERS);
+    mesh.indices.reserve(numCubes * CUBE_NUM_TRIANGLES * 3);
+    
+    std::unordered_map<weldKey, uint32_t, weldKeyHash> welded;
+    welded.reserve(numCubes * CUBE_NUM_CORNERS);
+    
+    const float invQuantum = 1.0f / MESH_WELD_QUANTUM;
+    
+    ofVec3f center;
+    float size;
+    ofVec3f corners[CUBE_NUM_CORNERS];
+    uint32_t cornerIndex[CUBE_NUM_CORNERS];
+    
+    for( unsigned long c = 0; c < numCubes; c++ ) {
+        getCube(c, center, size);
+        getCubeCorners(center.x, center.y, center.z, size, corners);
+        
+        for( int i = 0; i < CUBE_NUM_CORNERS; i++ ) {
+            weldKey key = { (int32_t)floorf(corners[i].x * invQuantum + 0.5f),
+                            (int32_t)floorf(corners[i].y * invQuantum + 0.5f),
+                            (int32_t)floorf(corners[i].z * invQuantum + 0.5f) };
+            
+            auto found = welded.find(key);
+            if( found != welded.end() )
+                cornerIndex[i] = found->second;
+            else {
+                cornerIndex[i] = mesh.addVertex(corners[i]);
+                welded[key] = cornerIndex[i];
+            }
+        }
+        
+        for( int t = 0; t < CUBE_NUM_TRIANGLES; t++ )
+            mesh.addTriangle(cornerIndex[cubeTriangleCorners[t][0]],
+                             cornerIndex[cubeTriangleCorners[t][1]],
+                             cornerIndex[cubeTriangleCorners[t][2]]);
+    }
+}
+
+bool saveMeshPLY( const string &path, const string &modelName, const indexedMesh &mesh ) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if( file == NULL ) {
+        cout << "ERROR saveMeshPLY() can't open " << path << "\n";
+        return false;
+    }
+    
+    unsigned long numVertices = mesh.vertices.size();
+    unsigned long numFaces = mesh.getNumTriangles();
+    
+    bool bOK = fprintf(file,
+                       "ply\n"
+                       "format binary_little_endian 1.0\n"
+                       "comment %s\n"
+                       "element vertex %lu\n"
+                       "property float x\n"
+                       "property float y\n"
+                       "property float z\n"
+                       "element face %lu\n"
+                       "property list uchar int vertex_indices\n"
+                       "end_header\n",
+                       modelName.c_str(), numVertices, numFaces) > 0;
+    
+    //-- vertices, straight from the mesh
+    vector<float> xyz(MESH_CHUNK_ITEMS * 3);
+    
+    for( unsigned long first = 0; bOK && first < numVertices; first += MESH_CHUNK_ITEMS ) {
+        unsigned long count = numVertices - first;
+        if( count > MESH_CHUNK_ITEMS )
+            count = MESH_CHUNK_ITEMS;
+        
+        for( unsigned long i = 0; i < count; i++ ) {
+            const ofVec3f &v = mesh.vertices[first + i];
+            xyz[i*3] = v.x;
+            xyz[i*3 + 1] = v.y;
+            xyz[i*3 + 2] = v.z;
+        }
+        
+        bOK = fwrite(&xyz[0], sizeof(float) * 3, count, file) == count;
+    }
+    
+    //-- faces, packed as 13 bytes each
+    vector<char> buffer(MESH_CHUNK_ITEMS * PLY_FACE_SIZE);
+    
+    for( unsigned long first = 0; bOK && first < numFaces; first += MESH_CHUNK_ITEMS ) {
+        unsigned long count = numFaces - first;
+        if( count > MESH_CHUNK_ITEMS )
+            count = MESH_CHUNK_ITEMS;
+        
+        char *p = &buffer[0];
+        for( unsigned long f = first; f < first + count; f++ ) {
+            *p++ = 3;
+
+            int32_t face[3] = { (int32_t)mesh.indices[f*3], (int32_t)mesh.indices[f*3 + 1], (int32_t)mesh.indices[f*3 + 2] };
+            memcpy(p, face, sizeof(face));
+            p += sizeof(face);
+        }
+        
+        bOK = fwrite(&buffer[0], PLY_FACE_SIZE, count, file) == count;
+    }
+    
+    if( fclose(file) != 0 )
+        bOK = false;
+    
+    if( bOK == false )
+        cout << "ERROR saveMeshPLY() couldn't write all of " << path << "\n";
+    
+    return bOK;
+}
+
+bool saveMeshOBJ( const string &path, const string &modelName, const indexedMesh &mesh ) {
+    FILE *file = fopen(path.c_str(), "w");
+    if( file == NULL ) {
+        cout << "ERROR saveMeshOBJ() can't open " << path << "\n";
+        return false;
+    }
+    
+    //-- stdio does the buffering, a big buffer keeps the fprintf()s cheap
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    
+    bool bOK = fprintf(file, "# %s\no %s\n", modelName.c_str(), modelName.c_str()) > 0;
+    
+    for( unsigned long i = 0; bOK && i < mesh.vertices.size(); i++ ) {
+        const ofVec3f &v = mesh.vertices[i];
+        bOK = fprintf(file, "v %.9g %.9g %.9g\n", v.x, v.y, v.z) > 0;
+    }
+    
+    for( unsigned long f = 0; bOK && f < mesh.getNumTriangles(); f++ )
+        bOK = fprintf(file, "f %u %u %u\n", mesh.indices[f*3] + 1, mesh.indices[f*3 + 1] + 1, mesh.indices[f*3 + 2] + 1) > 0;
+    
+    if( fclose(file) != 0 )
+        bOK = false;
+    
+    if( bOK == false )
+        cout << "ERROR saveMeshOBJ() couldn't write all of " << path << "\n";
+    
+    return bOK;
+}
+
+bool saveMeshFile( const string &path, const string &modelName, const indexedMesh &mesh ) {
+    string extension = ofToLower(ofFilePath::getFileExt(path));
+    
+    if( extension == "stl" )
+        return saveMeshSTL(path, modelName, mesh);
+    else if( extension == "ply" )
+        return saveMeshPLY(path, modelName, mesh);
+    else if( extension == "obj" )
+        return saveMeshOBJ(path, modelName, mesh);
+    
+    cout << "ERROR saveMeshFile() doesn't know the format of " << path << "\n";
+    return false;
+}
+
+bool isMeshFileFormat( const string &extension ) {
+    string lower = ofToLower(extension);
+    return lower == "stl" || lower == "ply" || lower == "obj";
+}
@@ -0,0 +1,42 @@
+/*********************************************************
+    meshWriter.h
+    Indexed mesh export (binary PLY, OBJ) for Data Crystals
+
+    Notes:
+    - unlike STL, vertices are written once and triangles index them,
+        so a cube is 8 vertices instead of 36
+
+    - buildCubesMesh() welds corners through a hash of their positions
+        quantised to MESH_WELD_QUANTUM, so corners that touch are shared
+        between cubes as well
+
+    - saveMeshFile() picks the format from the extension of the path,
+        .stl, .ply or .obj, so callers only choose a path
+
+    - binary PLY is little-endian, as are all the machines we build for
+**********************************************************/
+
+
+#ifndef __meshWriter__
+#define __meshWriter__
+
+#include "ofMain.h"
+#include "indexedMesh.h"
+#include "stlWriter.h"
+
+//-- corners closer than this are the same vertex
+#define MESH_WELD_QUANTUM (1.0f / 1024.0f)
+
+//-- the 12 triangles of each of numCubes cubes, with shared corners
+void buildCubesMesh( unsigned long numCubes, const stlCubeSource &getCube, indexedMesh &mesh );
+
+bool saveMeshPLY( const string &path, const string &modelName, const indexedMesh &mesh );
+bool saveMeshOBJ( const string &path, const string &modelName, const indexedMesh &mesh );
+
+//-- by extension, false for one we don't know or if the file can't be written
+bool saveMeshFile( const string &path, const string &modelName, const indexedMesh &mesh );
+
+//-- true for .stl, .ply and .obj
+bool isMeshFileFormat( const string &extension );
+
+#endif /* defined(__meshWriter__) */
@@ -0,0 +1,81 @@
+/*********************************************************
+ spatialGrid.cpp
+ Uniform spatial hash grid implementation for Data Crystals
+ 
+ **********************************************************/
+
+#include "spatialGrid.h"
+
+#define MIN_GRID_BUCKETS (1024)
+
+
+spatialGrid::spatialGrid() {
+    cellSize = DEFAULT_CUBE_SIZE;
+    invCellSize = 1.0f / cellSize;
+    numBuckets = 0;
+    dataStart = 0;
+}
+
+unsigned long spatialGrid::hashCell( int cx, int cy, int cz ) {
+    // large primes from Teschner et al., "Optimized Spatial Hashing for Collision Detection"
+    unsigned long h = ((unsigned long)cx * 73856093UL) ^ ((unsigned long)cy * 19349663UL) ^ ((unsigned long)cz * 83492791UL);
+    return h & (numBuckets - 1);
+}
+
+//-- false if it can't be used, also sizes the bucket table for numData points
+bool spatialGrid::setCellSize( float _cellSize, unsigned long numData ) {
+    if( _cellSize <= 0 ) {
+        cout << "ERROR spatialGrid::build() has a zero cell size\n";
+        return false;
+    }
+    
+    cellSize = _cellSize;
+    invCellSize = 1.0f / cellSize;
+    
+    //-- ~1 bucket per point, clustered data shares cells, so that still keeps the collisions low
+    unsigned long wantBuckets = MIN_GRID_BUCKETS;
+    while( wantBuckets < numData )
+        wantBuckets <<= 1;
+    
+    numBuckets = wantBuckets;
+    return true;
+}
+
+void spatialGrid::getNeighborRanges( const ofVec3f &loc, vector< pair<unsigned long, unsigned long> > &ranges ) {
+    ranges.clear();
+    
+    if( numBuckets == 0 )
+        return;
+    
+    int cx = cellCoord(loc.x);
+    int cy = cellCoord(loc.y);
+    int cz = cellCoord(loc.z);
+    
+    //-- two cells can hash to the same bucket, don't visit a bucket twice
+    unsigned long visited[27];
+    int numVisited = 0;
+    
+    for( int dx = -1; dx <= 1; dx++ ) {
+        for( int dy = -1; dy <= 1; dy++ ) {
+            for( int dz = -1; dz <= 1; dz++ ) {
+                unsigned long b = hashCell(cx+dx, cy+dy, cz+dz);
+                
+                bool seen = false;
+                for( int v = 0; v < numVisited; v++ ) {
+                    if( visited[v] == b ) {
+                        seen = true;
+                        break;
+                    }
+                }
+                
+                if( seen )
+                    continue;
+                
+                visited[numVisited++] = b;
+                
+                if( bucketStart[b+1] > bucketStart[b] )
+                    ranges.push_back(make_pair(bucketStart[b], bucketStart[b+1]));
+            }
+        }
+    }
+}
@@ -0,0 +1,124 @@
+/*********************************************************
+    spatialGrid.h
+    Uniform spatial hash grid for Data Crystals
+ 
+    Notes:
+    - broadphase for dataCrystalsApp::makeClusters(), so that each
+        datum is only tested against data in its own and the 26
+        neighbouring cells instead of against every other datum
+ 
+    - cell size should be the cluster distance, so anything within
+        range is always in an adjacent cell
+ 
+    - cells are hashed into a fixed table (sized from the number of
+        points), so hash collisions just add a few extra candidates,
+        which the real distance test filters out
+ 
+    - positions only change in jiggle(), so rebuild once per cycle
+ 
+    - positions are copied out in bucket order as well, so every bucket
+        is a contiguous block of x, y and z for findWithinDistance(), and
+        this is the only copy of them, see getEntryOf()
+ 
+    - 32-bit indices, per point that is the entry, its x, y and z, and
+        which entry a datum is, 20 bytes, plus 4 to 8 bytes of buckets
+**********************************************************/
+
+
+#ifndef __spatialGrid__
+#define __spatialGrid__
+
+#include "datumStore.h"
+#include <stdint.h>
+
+
+class spatialGrid  {
+
+public:
+    spatialGrid();
+    
+    //-- bin data [start, end) into cells of edge cellSize, O(N), getLoc(i, loc) gives the world
+    //-- position of datum i, it is called twice per datum so should be cheap
+    template <typename LocFunc>
+    void build( LocFunc getLoc, unsigned long start, unsigned long end, float cellSize );
+    
+    //-- fills ranges with the [begin, end) entry offsets of the buckets for the 27 cells around loc,
+    //-- the vector is cleared first so callers can re-use it
+    void getNeighborRanges( const ofVec3f &loc, vector< pair<unsigned long, unsigned long> > &ranges );
+    
+    //-- entry offset of datum i, which has to be in [start, end) of the last build()
+    unsigned long getEntryOf( unsigned long i ) { return dataEntry[i - dataStart]; }
+    
+    //-- entry offset -> datum index, and the positions of each entry
+    const uint32_t *getEntries() { return entries.data(); }
+    const float *getEntryX() { return entryX.data(); }
+    const float *getEntryY() { return entryY.data(); }
+    const float *getEntryZ() { return entryZ.data(); }
+    
+    float getCellSize() { return cellSize; }
+    
+private:
+    float cellSize;
+    float invCellSize;
+    
+    //-- always a power of 2, so we can mask instead of mod
+    unsigned long numBuckets;
+    
+    //-- bucket b owns entries[ bucketStart[b] ... bucketStart[b+1] ), i.e. a counting sort
+    vector<uint32_t> bucketStart;
+    vector<uint32_t> entries;
+    vector<float> entryX, entryY, entryZ;
+    
+    //-- by datum - dataStart, the bucket it landed in while building, then its entry offset
+    vector<uint32_t> dataEntry;
+    unsigned long dataStart;
+    
+    int cellCoord( float v ) { return (int)floorf(v * invCellSize); }
+    unsigned long hashCell( int cx, int cy, int cz );
+    bool setCellSize( float cellSize, unsigned long numData );
+};
+
+
+template <typename LocFunc>
+void spatialGrid::build( LocFunc getLoc, unsigned long start, unsigned long end, float _cellSize ) {
+    unsigned long numData = end - start;
+    
+    if( setCellSize(_cellSize, numData) == false )
+        return;
+    
+    dataStart = start;
+    bucketStart.assign(numBuckets + 1, 0);
+    dataEntry.resize(numData);
+    entries.resize(numData);
+    entryX.resize(numData);
+    entryY.resize(numData);
+    entryZ.resize(numData);
+    
+    // 1st pass: count points per bucket, bucketStart[b] is the count of b for now
+    ofVec3f loc;
+    for( unsigned long i = start; i < end; i++ ) {
+        getLoc(i, loc);
+        uint32_t b = (uint32_t)hashCell( cellCoord(loc.x), cellCoord(loc.y), cellCoord(loc.z) );
+        dataEntry[i - start] = b;
+        bucketStart[b]++;
+    }
+    
+    // 2nd pass: running sum, bucketStart[b] is now where b ends
+    for( unsigned long b = 1; b <= numBuckets; b++ )
+        bucketStart[b] += bucketStart[b-1];
+    
+    // 3rd pass: scatter backwards, which leaves bucketStart[b] where b starts, and each bucket in index
+    // order, so the neighbor lists are deterministic; positions go with it for the distance kernel
+    for( unsigned long i = end; i > start; i-- ) {
+        uint32_t e = --bucketStart[dataEntry[i - 1 - start]];
+        
+        getLoc(i - 1, loc);
+        entries[e] = (uint32_t)(i - 1);
+        entryX[e] = loc.x;
+        entryY[e] = loc.y;
+        entryZ[e] = loc.z;
+        dataEntry[i - 1 - start] = e;
+    }
+}
+
+#endif /* defined(__spatialGrid__) */
@@ -0,0 +1,170 @@
+/*********************************************************
+ stlWriter.cpp
+ Streaming binary STL export of cubes implementation for Data Crystals
+ 
+ Binary STL: 80-byte header, uint32 triangle count, then per triangle
+ a normal and 3 vertices (12 floats) and a uint16 attribute, 50 bytes
+ 
+ **********************************************************/
+
+#include "stlWriter.h"
+#include "cubeGeometry.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define STL_HEADER_SIZE (80)
+#define STL_TRIANGLE_SIZE (50)
+#define STL_CUBE_SIZE (CUBE_NUM_TRIANGLES * STL_TRIANGLE_SIZE)
+#define STL_CHUNK_CUBES (8192)          // ~4.9 MB per chunk
+
+
+static void putFloats( char *&p, const ofVec3f &v ) {
+    float f[3] = { v.x, v.y, v.z };
+    memcpy(p, f, sizeof(f));
+    p += sizeof(f);
+}
+
+//-- triangles for cubes [first, first + count) into buffer
+static void fillChunk( char *buffer, unsigned long first, unsigned long count, const stlCubeSource &getCube ) {
+    char *p = buffer;
+    const uint16_t attribute = 0;
+    
+    ofVec3f center;
+    float size;
+    ofVec3f corners[CUBE_NUM_CORNERS];
+    
+    for( unsigned long c = first; c < first + count; c++ ) {
+        getCube(c, center, size);
+        getCubeCorners(center.x, center.y, center.z, size, corners);
+        
+        for( int t = 0; t < CUBE_NUM_TRIANGLES; t++ ) {
+            putFloats(p, cubeTriangleNormals[t]);
+            putFloats(p, corners[cubeTriangleCorners[t][0]]);
+            putFloats(p, corners[cubeTriangleCorners[t][1]]);
+            putFloats(p, corners[cubeTriangleCorners[t][2]]);
+            memcpy(p, &attribute, sizeof(attribute));
+            p += sizeof(attribute);
+        }
+    }
+}
+
+//-- header and triangle count, the file is left open for the triangles
+static FILE *openSTL( const string &path, const string &modelName, uint32_t numTriangles ) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if( file == NULL ) {
+        cout << "ERROR openSTL() can't open " << path << "\n";
+        return NULL;
+    }
+    
+    char header[STL_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    strncpy(header, modelName.c_str(), sizeof(header) - 1);
+    
+    if( fwrite(header, sizeof(header), 1, file) != 1 ||
+        fwrite(&numTriangles, sizeof(numTriangles), 1, file) != 1 ) {
+        cout << "ERROR openSTL() couldn't write the header of " << path << "\n";
+        fclose(file);
+        return NULL;
+    }
+    
+    return file;
+}
+
+bool saveCubesSTL( const string &path, const string &modelName, unsigned long numCubes,
+                   const stlCubeSource &getCube, threadPool *threads ) {
+    FILE *file = openSTL(path, modelName, (uint32_t)(numCubes * CUBE_NUM_TRIANGLES));
+    if( file == NULL )
+        return false;
+    
+    bool bOK = true;
+    
+    //-- one chunk per thread in flight, filled in parallel, written in order
+    int numBuffers = (threads != NULL) ? threads->getNumThreads() : 1;
+    if( numBuffers < 1 )
+        numBuffers = 1;
+    
+    vector< vector<char> > buffers(numBuffers);
+    vector<unsigned long> bufferCubes(numBuffers);
+    
+    unsigned long numChunks = (numCubes + STL_CHUNK_CUBES - 1) / STL_CHUNK_CUBES;
+    
+    for( unsigned long firstChunk = 0; bOK && firstChunk < numChunks; firstChunk += numBuffers ) {
+        unsigned long numJobs = numChunks - firstChunk;
+        if( numJobs > (unsigned long)numBuffers )
+            numJobs = numBuffers;
+        
+        auto fillJob = [&](unsigned long job, int) {
+            unsigned long first = (firstChunk + job) * STL_CHUNK_CUBES;
+            unsigned long count = numCubes - first;
+            if( count > STL_CHUNK_CUBES )
+                count = STL_CHUNK_CUBES;
+            
+            buffers[job].resize(STL_CHUNK_CUBES * STL_CUBE_SIZE);
+            bufferCubes[job] = count;
+            fillChunk(&buffers[job][0], first, count, getCube);
+        };
+        
+        if( threads != NULL )
+            threads->run(numJobs, fillJob);
+        else
+            fillJob(0, 0);
+        
+        for( unsigned long job = 0; bOK && job < numJobs; job++ )
+            bOK = fwrite(&buffers[job][0], STL_CUBE_SIZE, bufferCubes[job], file) == bufferCubes[job];
+    }
+    
+    if( fclose(file) != 0 )
+        bOK = false;
+    
+    if( bOK == false )
+        cout << "ERROR saveCubesSTL() couldn't write all of " << path << "\n";
+    
+    return bOK;
+}
+
+bool saveMeshSTL( const string &path, const string &modelName, const indexedMesh &mesh ) {
+    unsigned long numTriangles = mesh.getNumTriangles();
+    
+    FILE *file = openSTL(path, modelName, (uint32_t)numTriangles);
+    if( file == NULL )
+        return false;
+    
+    bool bOK = true;
+    const uint16_t attribute = 0;
+    const unsigned long chunkTriangles = STL_CHUNK_CUBES * CUBE_NUM_TRIANGLES;
+    vector<char> buffer(chunkTriangles * STL_TRIANGLE_SIZE);
+    
+    for( unsigned long first = 0; bOK && first < numTriangles; first += chunkTriangles ) {
+        unsigned long count = numTriangles - first;
+        if( count > chunkTriangles )
+            count = chunkTriangles;
+        
+        char *p = &buffer[0];
+        for( unsigned long t = first; t < first + count; t++ ) {
+            const ofVec3f &a = mesh.vertices[mesh.indices[t*3]];
+            const ofVec3f &b = mesh.vertices[mesh.indices[t*3 + 1]];
+            const ofVec3f &c = mesh.vertices[mesh.indices[t*3 + 2]];
+            
+            ofVec3f normal = (b - a).getCrossed(c - a).getNormalized();
+            
+            putFloats(p, normal);
+            putFloats(p, a);
+            putFloats(p, b);
+            putFloats(p, c);
+            memcpy(p, &attribute, sizeof(attribute));
+            p += sizeof(attribute);
+        }
+        
+        bOK = fwrite(&buffer[0], STL_TRIANGLE_SIZE, count, file) == count;
+    }
+    
+    if( fclose(file) != 0 )
+        bOK = false;
+    
+    if( bOK == false )
+        cout << "ERROR saveMeshSTL() couldn't write all of " << path << "\n";
+    
+    return bOK;
+}
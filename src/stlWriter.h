@@ -0,0 +1,42 @@
+/*********************************************************
+    stlWriter.h
+    Streaming binary STL export of cubes for Data Crystals
+ 
+    Notes:
+    - the 12 triangles of each cube are made from its center and
+        size as they are written, there is no mesh in memory
+ 
+    - triangles go into fixed-size chunks that are written with one
+        fwrite() each, so memory use doesn't grow with the crystal
+ 
+    - with a threadPool, one chunk per thread is filled at a time and
+        the chunks are written in order, so the file is the same as
+        a single-threaded export
+ 
+    - saveMeshSTL() writes an already built mesh, such as the merged
+        surface from voxelGrid, in the same chunks, single-threaded
+
+    - binary STL is little-endian, as are all the machines we build for
+**********************************************************/
+
+
+#ifndef __stlWriter__
+#define __stlWriter__
+
+#include "ofMain.h"
+#include "threadPool.h"
+#include "indexedMesh.h"
+#include <functional>
+
+
+//-- fills in the center and edge size of cube i, may be called from several threads at once
+typedef std::function<void(unsigned long i, ofVec3f &center, float &size)> stlCubeSource;
+
+//-- writes numCubes cubes to path, false if the file can't be written
+bool saveCubesSTL( const string &path, const string &modelName, unsigned long numCubes,
+                   const stlCubeSource &getCube, threadPool *threads = NULL );
+
+//-- writes every triangle of mesh to path, normals come from the winding
+bool saveMeshSTL( const string &path, const string &modelName, const indexedMesh &mesh );
+
+#endif /* defined(__stlWriter__) */
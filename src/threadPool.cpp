@@ -0,0 +1,115 @@
+/*********************************************************
+ threadPool.cpp
+ Fixed-size worker pool implementation for Data Crystals
+ 
+ **********************************************************/
+
+#include "threadPool.h"
+
+
+threadPool::threadPool() {
+    numThreads = 1;
+    currentJob = NULL;
+    numJobs = 0;
+    nextJob = 0;
+    generation = 0;
+    numBusy = 0;
+    bQuit = false;
+}
+
+threadPool::~threadPool() {
+    stop();
+}
+
+void threadPool::setup( int _numThreads ) {
+    stop();
+    
+    if( _numThreads <= 0 )
+        _numThreads = std::thread::hardware_concurrency();
+    
+    if( _numThreads <= 0 )
+        _numThreads = 1;
+    
+    //-- all the old workers are joined, so nobody is waiting on a generation
+    numThreads = _numThreads;
+    generation = 0;
+    bQuit = false;
+    
+    //-- the calling thread is thread 0
+    for( int i = 1; i < numThreads; i++ )
+        workers.push_back(std::thread(&threadPool::workerLoop, this, i));
+}
+
+void threadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        bQuit = true;
+    }
+    wakeCondition.notify_all();
+    
+    for( size_t i = 0; i < workers.size(); i++ )
+        workers[i].join();
+    
+    workers.clear();
+    numThreads = 1;
+}
+
+void threadPool::run( unsigned long _numJobs, const std::function<void(unsigned long, int)> &job ) {
+    if( workers.size() == 0 || _numJobs <= 1 ) {
+        for( unsigned long i = 0; i < _numJobs; i++ )
+            job(i, 0);
+        return;
+    }
+    
+    std::lock_guard<std::mutex> runLock(runMutex);
+    
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        currentJob = &job;
+        numJobs = _numJobs;
+        nextJob = 0;
+        numBusy = workers.size();
+        generation++;
+    }
+    wakeCondition.notify_all();
+    
+    doJobs(0);
+    
+    std::unique_lock<std::mutex> lock(poolMutex);
+    while( numBusy > 0 )
+        doneCondition.wait(lock);
+    
+    currentJob = NULL;
+}
+
+void threadPool::doJobs( int threadIndex ) {
+    unsigned long j;
+    while( (j = nextJob++) < numJobs )
+        (*currentJob)(j, threadIndex);
+}
+
+void threadPool::workerLoop( int threadIndex ) {
+    unsigned long lastGeneration = 0;
+    
+    while( true ) {
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            while( bQuit == false && generation == lastGeneration )
+                wakeCondition.wait(lock);
+            
+            if( bQuit )
+                return;
+            
+            lastGeneration = generation;
+        }
+        
+        doJobs(threadIndex);
+        
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            numBusy--;
+            if( numBusy == 0 )
+                doneCondition.notify_one();
+        }
+    }
+}
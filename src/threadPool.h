@@ -0,0 +1,66 @@
+/*********************************************************
+    threadPool.h
+    Fixed-size worker pool for Data Crystals
+ 
+    Notes:
+    - run() hands out job indexes [0, numJobs) to the workers and
+        blocks until every job is done, the calling thread works too
+ 
+    - jobs are handed out in order but finish in any order, so
+        anything that needs a stable result should write into a
+        per-job buffer and merge them afterwards
+ 
+    - with 1 thread (or setup() never called), run() is just a loop
+ 
+    - run() may be called from more than one thread, the batches
+        just take turns
+**********************************************************/
+
+
+#ifndef __threadPool__
+#define __threadPool__
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+
+class threadPool  {
+
+public:
+    threadPool();
+    ~threadPool();
+    
+    //-- numThreads includes the calling thread, 0 = one per core
+    void setup( int _numThreads = 0 );
+    int getNumThreads() { return numThreads; }
+    
+    //-- calls job(jobIndex, threadIndex) for every jobIndex, threadIndex is in [0, getNumThreads())
+    void run( unsigned long _numJobs, const std::function<void(unsigned long, int)> &job );
+    
+private:
+    void workerLoop( int threadIndex );
+    void doJobs( int threadIndex );
+    void stop();
+    
+    int numThreads;
+    std::vector<std::thread> workers;
+    
+    std::mutex poolMutex;
+    std::mutex runMutex;        // one batch at a time
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    
+    //-- current batch, only changed under poolMutex while the workers are idle
+    const std::function<void(unsigned long, int)> *currentJob;
+    unsigned long numJobs;
+    std::atomic<unsigned long> nextJob;
+    unsigned long generation;
+    int numBusy;
+    bool bQuit;
+};
+
+#endif /* defined(__threadPool__) */
@@ -0,0 +1,303 @@
+/*********************************************************
+ voxelGrid.cpp
+ Voxelised, watertight surface implementation for Data Crystals
+ 
+ Face directions are -x, +x, -y, +y, -z, +z as in cubeGeometry.h, for
+ direction d the face's axis is d/2, and (u, v) are the other two axes
+ in cyclic order, so u x v points along +axis
+ 
+ **********************************************************/
+
+#include "voxelGrid.h"
+#include <algorithm>
+#include <unordered_map>
+
+#define VOXEL_COORD_BITS (21)
+#define VOXEL_COORD_MASK ((1ULL << VOXEL_COORD_BITS) - 1)
+#define VOXEL_COORD_BIAS (1LL << (VOXEL_COORD_BITS - 1))
+
+#define NUM_FACE_DIRECTIONS (6)
+
+
+//-- lattice point or voxel (its min corner) -> key, sorted keys run x fastest
+static uint64_t packLattice( const int64_t *p ) {
+    return  (uint64_t)(p[0] + VOXEL_COORD_BIAS) |
+           ((uint64_t)(p[1] + VOXEL_COORD_BIAS) << VOXEL_COORD_BITS) |
+           ((uint64_t)(p[2] + VOXEL_COORD_BIAS) << (VOXEL_COORD_BITS * 2));
+}
+
+static void unpackLattice( uint64_t key, int64_t *p ) {
+    for( int a = 0; a < 3; a++ )
+        p[a] = (int64_t)((key >> (VOXEL_COORD_BITS * a)) & VOXEL_COORD_MASK) - VOXEL_COORD_BIAS;
+}
+
+static bool inLattice( int64_t c ) {
+    // leaves room for the far corner of the last voxel
+    return c >= -VOXEL_COORD_BIAS && c < VOXEL_COORD_BIAS - 1;
+}
+
+//-- one boundary face, grouped by plane, then sorted by v then u within it
+struct voxelFace {
+    uint64_t plane;     // direction << 32 | biased slice
+    uint64_t cell;      // biased v << 32 | biased u
+    
+    bool operator<( const voxelFace &f ) const {
+        return plane < f.plane || (plane == f.plane && cell < f.cell);
+    }
+};
+
+//-- a merged block of faces, in lattice units
+struct voxelRect {
+    int dir;
+    int64_t slice, u0, v0, w, h;
+};
+
+
+voxelGrid::voxelGrid() {
+    voxelSize = 1;
+    bSorted = true;
+}
+
+void voxelGrid::clear( float _voxelSize ) {
+    voxels.clear();
+    bSorted = true;
+    
+    if( _voxelSize <= 0 ) {
+        cout << "ERROR voxelGrid::clear() has a zero voxel size\n";
+        _voxelSize = 1;
+    }
+    
+    voxelSize = _voxelSize;
+}
+
+void voxelGrid::addCube( const ofVec3f &center, float size ) {
+    const float centerCoords[3] = { center.x, center.y, center.z };
+    int64_t lo[3], hi[3];
+    
+    //-- voxel k's center is at (k + .5) * voxelSize, keep the ones in [center - size/2, center + size/2)
+    for( int a = 0; a < 3; a++ ) {
+        float c = centerCoords[a] / voxelSize;
+        float halfSize = size * 0.5f / voxelSize;
+        
+        lo[a] = (int64_t)ceilf(c - halfSize - 0.5f);
+        hi[a] = (int64_t)ceilf(c + halfSize - 0.5f) - 1;
+        
+        // cubes smaller than a voxel still get the one they're in
+        if( hi[a] < lo[a] )
+            lo[a] = hi[a] = (int64_t)floorf(c);
+        
+        if( inLattice(lo[a]) == false || inLattice(hi[a]) == false ) {
+            cout << "ERROR voxelGrid::addCube() cube at " << center.x << ", " << center.y << ", " << center.z << " is off the lattice\n";
+            return;
+        }
+    }
+    
+    int64_t p[3];
+    for( p[2] = lo[2]; p[2] <= hi[2]; p[2]++ )
+        for( p[1] = lo[1]; p[1] <= hi[1]; p[1]++ )
+            for( p[0] = lo[0]; p[0] <= hi[0]; p[0]++ )
+                voxels.push_back(packLattice(p));
+    
+    bSorted = false;
+}
+
+void voxelGrid::finishVoxels() {
+    if( bSorted )
+        return;
+    
+    std::sort(voxels.begin(), voxels.end());
+    voxels.erase(std::unique(voxels.begin(), voxels.end()), voxels.end());
+    bSorted = true;
+}
+
+unsigned long voxelGrid::getNumVoxels() {
+    finishVoxels();
+    return voxels.size();
+}
+
+bool voxelGrid::hasVoxel( uint64_t key ) {
+    return std::binary_search(voxels.begin(), voxels.end(), key);
+}
+
+void voxelGrid::buildSurface( indexedMesh &mesh ) {
+    mesh.clear();
+    finishVoxels();
+    
+    //-- 1: every face between a filled and an empty voxel
+    const uint64_t axisStep[3] = { 1ULL, 1ULL << VOXEL_COORD_BITS, 1ULL << (VOXEL_COORD_BITS * 2) };
+    vector<voxelFace> faces;
+    
+    for( unsigned long i = 0; i < voxels.size(); i++ ) {
+        uint64_t key = voxels[i];
+        int64_t p[3];
+        unpackLattice(key, p);
+        
+        for( int d = 0; d < NUM_FACE_DIRECTIONS; d++ ) {
+            int a = d / 2;
+            bool bPositive = (d & 1);
+            
+            // +/- x neighbors are next to each other in the sorted keys
+            bool bCovered;
+            if( a == 0 )
+                bCovered = bPositive ? (i + 1 < voxels.size() && voxels[i+1] == key + 1) : (i > 0 && voxels[i-1] == key - 1);
+            else
+                bCovered = hasVoxel(bPositive ? key + axisStep[a] : key - axisStep[a]);
+            
+            if( bCovered )
+                continue;
+            
+            int u = (a + 1) % 3;
+            int v = (a + 2) % 3;
+            int64_t slice = bPositive ? p[a] + 1 : p[a];
+            
+            voxelFace f;
+            f.plane = ((uint64_t)d << 32) | (uint64_t)(slice + VOXEL_COORD_BIAS);
+            f.cell = ((uint64_t)(p[v] + VOXEL_COORD_BIAS) << 32) | (uint64_t)(p[u] + VOXEL_COORD_BIAS);
+            faces.push_back(f);
+        }
+    }
+    
+    std::sort(faces.begin(), faces.end());
+    
+    //-- 2: greedy merge within each plane, widest run along u first, then as many rows of it as fit
+    vector<voxelRect> rects;
+    vector<char> used(faces.size(), 0);
+    
+    for( unsigned long groupStart = 0; groupStart < faces.size(); ) {
+        unsigned long groupEnd = groupStart;
+        while( groupEnd < faces.size() && faces[groupEnd].plane == faces[groupStart].plane )
+            groupEnd++;
+        
+        for( unsigned long i = groupStart; i < groupEnd; i++ ) {
+            if( used[i] )
+                continue;
+            
+            uint64_t cell = faces[i].cell;
+            
+            // cells of a row are consecutive in the sorted faces
+            uint64_t w = 1;
+            while( i + w < groupEnd && faces[i+w].cell == cell + w && used[i+w] == 0 )
+                w++;
+            
+            uint64_t h = 1;
+            for( ;; h++ ) {
+                uint64_t rowCell = cell + (h << 32);
+                voxelFace probe = { faces[i].plane, rowCell };
+                unsigned long j = std::lower_bound(faces.begin() + groupStart, faces.begin() + groupEnd, probe) - faces.begin();
+                
+                bool bFullRow = true;
+                for( uint64_t t = 0; t < w && bFullRow; t++ )
+                    bFullRow = (j + t < groupEnd && faces[j+t].cell == rowCell + t && used[j+t] == 0);
+                
+                if( bFullRow == false )
+                    break;
+                
+                for( uint64_t t = 0; t < w; t++ )
+                    used[j+t] = 1;
+            }
+            
+            for( uint64_t t = 0; t < w; t++ )
+                used[i+t] = 1;
+            
+            voxelRect r;
+            r.dir = (int)(faces[i].plane >> 32);
+            r.slice = (int64_t)(faces[i].plane & 0xFFFFFFFFULL) - VOXEL_COORD_BIAS;
+            r.u0 = (int64_t)(cell & 0xFFFFFFFFULL) - VOXEL_COORD_BIAS;
+            r.v0 = (int64_t)(cell >> 32) - VOXEL_COORD_BIAS;
+            r.w = (int64_t)w;
+            r.h = (int64_t)h;
+            rects.push_back(r);
+        }
+        
+        groupStart = groupEnd;
+    }
+    
+    faces.clear();
+    faces.shrink_to_fit();
+    
+    //-- lattice point of (u, v) on a rect's plane
+    auto rectPoint = [](const voxelRect &r, int64_t u, int64_t v, int64_t *p) {
+        int a = r.dir / 2;
+        p[a] = r.slice;
+        p[(a + 1) % 3] = u;
+        p[(a + 2) % 3] = v;
+    };
+    
+    //-- 3: every rect corner, a rect edge has to be split wherever one of these is on it
+    vector<uint64_t> corners;
+    corners.reserve(rects.size() * 4);
+    
+    for( unsigned long i = 0; i < rects.size(); i++ ) {
+        const voxelRect &r = rects[i];
+        int64_t p[3];
+        
+        rectPoint(r, r.u0, r.v0, p);                 corners.push_back(packLattice(p));
+        rectPoint(r, r.u0 + r.w, r.v0, p);           corners.push_back(packLattice(p));
+        rectPoint(r, r.u0 + r.w, r.v0 + r.h, p);     corners.push_back(packLattice(p));
+        rectPoint(r, r.u0, r.v0 + r.h, p);           corners.push_back(packLattice(p));
+    }
+    
+    std::sort(corners.begin(), corners.end());
+    corners.erase(std::unique(corners.begin(), corners.end()), corners.end());
+    
+    //-- 4: triangles, lattice vertices are shared, a split rect gets a center vertex and a fan
+    std::unordered_map<uint64_t, uint32_t> latticeVertices;
+    latticeVertices.reserve(corners.size());
+    
+    auto getVertex = [&](const int64_t *p) {
+        uint64_t key = packLattice(p);
+        auto found = latticeVertices.find(key);
+        if( found != latticeVertices.end() )
+            return found->second;
+        
+        uint32_t index = mesh.addVertex(ofVec3f(p[0] * voxelSize, p[1] * voxelSize, p[2] * voxelSize));
+        latticeVertices[key] = index;
+        return index;
+    };
+    
+    vector<uint32_t> outline;
+    
+    for( unsigned long i = 0; i < rects.size(); i++ ) {
+        const voxelRect &r = rects[i];
+        
+        // counter-clockwise about +axis: along +u, +v, -u, -v
+        const int64_t startU[4] = { r.u0, r.u0 + r.w, r.u0 + r.w, r.u0 };
+        const int64_t startV[4] = { r.v0, r.v0, r.v0 + r.h, r.v0 + r.h };
+        const int64_t stepU[4] = { 1, 0, -1, 0 };
+        const int64_t stepV[4] = { 0, 1, 0, -1 };
+        const int64_t edgeLength[4] = { r.w, r.h, r.w, r.h };
+        
+        outline.clear();
+        
+        for( int e = 0; e < 4; e++ ) {
+            for( int64_t s = 0; s < edgeLength[e]; s++ ) {
+                int64_t p[3];
+                rectPoint(r, startU[e] + stepU[e] * s, startV[e] + stepV[e] * s, p);
+                
+                if( s == 0 || std::binary_search(corners.begin(), corners.end(), packLattice(p)) )
+                    outline.push_back(getVertex(p));
+            }
+        }
+        
+        // faces looking down -axis wind the other way
+        if( (r.dir & 1) == 0 )
+            std::reverse(outline.begin(), outline.end());
+        
+        if( outline.size() == 4 ) {
+            mesh.addTriangle(outline[0], outline[1], outline[2]);
+            mesh.addTriangle(outline[0], outline[2], outline[3]);
+        }
+        else {
+            int64_t p0[3], p1[3];
+            rectPoint(r, r.u0, r.v0, p0);
+            rectPoint(r, r.u0 + r.w, r.v0 + r.h, p1);
+            
+            uint32_t center = mesh.addVertex(ofVec3f((p0[0] + p1[0]) * 0.5f * voxelSize,
+                                                     (p0[1] + p1[1]) * 0.5f * voxelSize,
+                                                     (p0[2] + p1[2]) * 0.5f * voxelSize));
+            
+            for( unsigned long k = 0; k < outline.size(); k++ )
+                mesh.addTriangle(center, outline[k], outline[(k + 1) % outline.size()]);
+        }
+    }
+}
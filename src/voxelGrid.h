@@ -0,0 +1,62 @@
+/*********************************************************
+    voxelGrid.h
+    Voxelised, watertight surface of a crystal for Data Crystals
+    
+    Notes:
+    - cubes are rasterised onto a lattice of voxelSize, a voxel is
+        filled when its center is inside a cube, so overlapping cubes
+        just fill the same voxels
+    
+    - only faces between a filled and an empty voxel are kept, then the
+        faces of each plane are merged into rectangles greedily
+    
+    - rectangle edges are split wherever another rectangle has a corner
+        on them, so there are no T-junctions and every edge is shared by
+        two triangles (four where voxels only touch along an edge)
+    
+    - voxels are a sorted vector of packed lattice keys rather than a
+        hash set, ~8 bytes per voxel, lookups are binary searches
+    
+    - lattice coordinates are 21 bits, +/- ~1M voxels from the origin
+**********************************************************/
+
+
+#ifndef __voxelGrid__
+#define __voxelGrid__
+
+#include "ofMain.h"
+#include "indexedMesh.h"
+#include <stdint.h>
+
+//-- voxels per cube edge, 1 snaps each cube to one voxel
+#define VOXEL_DEFAULT_RESOLUTION (2)
+
+
+class voxelGrid  {
+
+public:
+    voxelGrid();
+    
+    //-- empties the grid and sets the lattice spacing
+    void clear( float voxelSize );
+    
+    //-- fills the voxels inside the cube with edge size centered on center
+    void addCube( const ofVec3f &center, float size );
+    
+    unsigned long getNumVoxels();
+    
+    //-- boundary of the filled voxels, merged into as few triangles as possible
+    void buildSurface( indexedMesh &mesh );
+
+private:
+    float voxelSize;
+    
+    //-- unsorted and with duplicates until finishVoxels()
+    vector<uint64_t> voxels;
+    bool bSorted;
+    
+    void finishVoxels();
+    bool hasVoxel( uint64_t key );
+};
+
+#endif /* defined(__voxelGrid__) */